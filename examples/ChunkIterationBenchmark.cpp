@@ -0,0 +1,124 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+/*
+*	Integrates positions with System::ForEachChunk and SIMD, and compares it against iterating the system's ComponentTuples
+*	Built with the NEBULA_BUILD_EXAMPLES option, uses AVX2 when the compiler targets it and SSE otherwise
+*	Usage: ChunkIterationBenchmark [entityCount] [updateCount]
+*/
+
+#include "nebula/Nebula.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <immintrin.h>
+
+// Both components are 16 bytes, so two entities fill an AVX2 register
+struct PositionComponent { alignas( 16 ) float xyzw[4]; };
+struct VelocityComponent { alignas( 16 ) float xyzw[4]; };
+
+class ChunkIntegrationSystem : public Nebula::System<PositionComponent, VelocityComponent>
+{
+public:
+	static constexpr uint64_t ID = GENERATE_ID( "ChunkIntegrationSystem" );
+
+	ChunkIntegrationSystem() :
+		System( ID )
+	{}
+
+	virtual void Update( float deltaTime ) override
+	{
+		ForEachChunk<PositionComponent, VelocityComponent>( [deltaTime]( size_t count, PositionComponent* positions, VelocityComponent* velocities )
+		{
+			size_t i = 0;
+#if defined( __AVX2__ )
+			// Chunks are aligned, but runs passed around disabled entities or groups may not be, so the loads are unaligned
+			const __m256 dt = _mm256_set1_ps( deltaTime );
+			for( ; i + 2 <= count; i += 2 )
+			{
+				const __m256 velocity = _mm256_mul_ps( _mm256_loadu_ps( velocities[i].xyzw ), dt );
+				_mm256_storeu_ps( positions[i].xyzw, _mm256_add_ps( _mm256_loadu_ps( positions[i].xyzw ), velocity ) );
+			}
+#endif
+			const __m128 dt4 = _mm_set1_ps( deltaTime );
+			for( ; i < count; ++i )
+			{
+				const __m128 velocity = _mm_mul_ps( _mm_loadu_ps( velocities[i].xyzw ), dt4 );
+				_mm_storeu_ps( positions[i].xyzw, _mm_add_ps( _mm_loadu_ps( positions[i].xyzw ), velocity ) );
+			}
+		} );
+	}
+};
+
+class TupleIntegrationSystem : public Nebula::System<PositionComponent, VelocityComponent>
+{
+public:
+	static constexpr uint64_t ID = GENERATE_ID( "TupleIntegrationSystem" );
+
+	TupleIntegrationSystem() :
+		System( ID )
+	{}
+
+	virtual void Update( float deltaTime ) override
+	{
+		for( auto& componentTuple : GetComponents() )
+		{
+			PositionComponent* position = std::get<PositionComponent*>( componentTuple );
+			const VelocityComponent* velocity = std::get<VelocityComponent*>( componentTuple );
+			for( int k = 0; k < 4; ++k )
+			{
+				position->xyzw[k] += velocity->xyzw[k] * deltaTime;
+			}
+		}
+	}
+};
+
+// Average milliseconds per update of the passed system
+static double TimeUpdates( Nebula::ISystem& system, int updateCount )
+{
+	system.Update( 0.001f );	// Warms up the caches and packs the pools
+
+	const auto start = std::chrono::steady_clock::now();
+	for( int i = 0; i < updateCount; ++i )
+	{
+		system.Update( 0.001f );
+	}
+	const auto end = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::milli>( end - start ).count() / updateCount;
+}
+
+int main( int argc, char** argv )
+{
+	const size_t entityCount = argc > 1 ? static_cast<size_t>( std::strtoull( argv[1], nullptr, 10 ) ) : 1000000;
+	const int updateCount = argc > 2 ? std::atoi( argv[2] ) : 100;
+
+	Nebula::WorldLimits limits;
+	limits.m_maxEntities = entityCount + 1;
+
+	Nebula::World world( limits );
+	ChunkIntegrationSystem* chunkSystem = world.RegisterSystem<ChunkIntegrationSystem>();
+	TupleIntegrationSystem* tupleSystem = world.RegisterSystem<TupleIntegrationSystem>();
+
+	for( const Nebula::EntityId entityId : world.CreateEntities( entityCount ) )
+	{
+		world.AddComponentToEntity<PositionComponent>( entityId, PositionComponent{ { 0.0f, 0.0f, 0.0f, 1.0f } } );
+		world.AddComponentToEntity<VelocityComponent>( entityId, VelocityComponent{ { 1.0f, 2.0f, 3.0f, 0.0f } } );
+	}
+
+#if defined( __AVX2__ )
+	const char* instructionSet = "AVX2";
+#else
+	const char* instructionSet = "SSE";
+#endif
+
+	const double chunkMilliseconds = TimeUpdates( *chunkSystem, updateCount );
+	const double tupleMilliseconds = TimeUpdates( *tupleSystem, updateCount );
+
+	std::printf( "%zu entities, %d updates\n", entityCount, updateCount );
+	std::printf( "ForEachChunk (%s): %.3f ms per update\n", instructionSet, chunkMilliseconds );
+	std::printf( "ComponentTuples:    %.3f ms per update\n", tupleMilliseconds );
+	std::printf( "Speedup: %.2fx\n", tupleMilliseconds / chunkMilliseconds );
+
+	return 0;
+}
@@ -11,6 +11,10 @@
 #include "../src/core/World.h"
 #include "../src/core/Entity.h"
 #include "../src/core/Component.h"
+#include "../src/core/Reflection.h"
+#include "../src/core/DynamicBuffer.h"
+#include "../src/core/ChunkAllocator.h"
+#include "../src/core/Query.h"
 #include "../src/core/System.h"
 #include "../src/core/Parser.h"
 
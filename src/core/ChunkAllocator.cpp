@@ -0,0 +1,208 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#include "ChunkAllocator.h"
+
+#include "../utility/Memory.h"
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#define NEBULA_MAPPED_CHUNKS 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
+namespace Nebula
+{
+	constexpr size_t MappedChunkAllocator::ARENA_SIZE;
+	constexpr size_t MappedChunkAllocator::DEFAULT_RESIDENT_BYTES;
+
+	void* HeapChunkAllocator::Allocate( size_t size )
+	{
+		return AlignedAlloc( size, COMPONENT_CHUNK_ALIGNMENT );
+	}
+
+	void HeapChunkAllocator::Free( void* chunk, size_t )
+	{
+		AlignedFree( chunk );
+	}
+
+	MappedChunkAllocator::MappedChunkAllocator( const std::string& filePath, size_t residentBytes ) :
+		m_filePath( filePath ),
+		m_file( -1 ),
+		m_fileSize( 0 ),
+		m_pageSize( 4096 ),
+		m_arenas(),
+		m_arenaUsed( 0 ),
+		m_freeChunks(),
+		m_residentBytes( residentBytes ),
+		m_unpinnedChunks(),
+		m_unpinnedIndices(),
+		m_unpinnedBytes( 0 )
+	{
+#ifdef NEBULA_MAPPED_CHUNKS
+		m_file = open( filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600 );
+
+		const long pageSize = sysconf( _SC_PAGESIZE );
+		if( pageSize > 0 )
+		{
+			m_pageSize = static_cast<size_t>( pageSize );
+		}
+#endif
+	}
+
+	MappedChunkAllocator::~MappedChunkAllocator()
+	{
+#ifdef NEBULA_MAPPED_CHUNKS
+		if( m_file >= 0 )
+		{
+			// The pools have released their chunks by now
+			for( const Arena& arena : m_arenas )
+			{
+				munmap( arena.m_data, arena.m_size );
+			}
+			m_arenas.clear();
+
+			close( m_file );
+			unlink( m_filePath.c_str() );
+		}
+#endif
+	}
+
+	bool MappedChunkAllocator::IsMapped() const
+	{
+		return m_file >= 0;
+	}
+
+	size_t MappedChunkAllocator::GetMappedSize( size_t size ) const
+	{
+		return ( size + m_pageSize - 1 ) / m_pageSize * m_pageSize;
+	}
+
+	bool MappedChunkAllocator::MapArena( size_t minSize )
+	{
+#ifdef NEBULA_MAPPED_CHUNKS
+		const size_t arenaSize = std::max( ARENA_SIZE, GetMappedSize( minSize ) );
+
+		// The new region reads as zeroes until it is written, and takes no space on disk until then
+		if( ftruncate( m_file, static_cast<off_t>( m_fileSize + arenaSize ) ) != 0 )
+		{
+			return false;
+		}
+
+		void* data = mmap( nullptr, arenaSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, static_cast<off_t>( m_fileSize ) );
+		if( data == MAP_FAILED )	// The file keeps its new size, the next arena is mapped at the same offset
+		{
+			return false;
+		}
+
+		// Chunks are iterated front to back, let the kernel read ahead
+		madvise( data, arenaSize, MADV_SEQUENTIAL );
+
+		// The rest of the previous arena is left unused, it only costs address space
+		m_arenas.push_back( Arena{ static_cast<uint8_t*>( data ), arenaSize } );
+		m_fileSize += arenaSize;
+		m_arenaUsed = 0;
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void* MappedChunkAllocator::Allocate( size_t size )
+	{
+#ifdef NEBULA_MAPPED_CHUNKS
+		if( m_file >= 0 )
+		{
+			const size_t mappedSize = GetMappedSize( size );
+
+			std::vector<void*>& freeChunks = m_freeChunks[mappedSize];
+			if( !freeChunks.empty() )
+			{
+				void* chunk = freeChunks.back();
+				freeChunks.pop_back();
+				return chunk;
+			}
+
+			if( m_arenas.empty() || m_arenaUsed + mappedSize > m_arenas.back().m_size )
+			{
+				if( !MapArena( mappedSize ) )
+				{
+					return nullptr;
+				}
+			}
+
+			void* chunk = m_arenas.back().m_data + m_arenaUsed;
+			m_arenaUsed += mappedSize;
+			return chunk;
+		}
+#endif
+		return AlignedAlloc( size, COMPONENT_CHUNK_ALIGNMENT );
+	}
+
+	void MappedChunkAllocator::Free( void* chunk, size_t size )
+	{
+#ifdef NEBULA_MAPPED_CHUNKS
+		if( m_file >= 0 )
+		{
+			const size_t mappedSize = GetMappedSize( size );
+			RemoveUnpinned( chunk );
+
+			// The contents are no longer needed, the pages are dropped until the chunk is handed out again
+			madvise( chunk, mappedSize, MADV_DONTNEED );
+			m_freeChunks[mappedSize].push_back( chunk );
+			return;
+		}
+#endif
+		AlignedFree( chunk );
+	}
+
+	void MappedChunkAllocator::Pin( void* chunk, size_t size )
+	{
+#ifdef NEBULA_MAPPED_CHUNKS
+		if( m_file >= 0 && !RemoveUnpinned( chunk ) )	// Chunks that were kept resident need no read ahead
+		{
+			madvise( chunk, GetMappedSize( size ), MADV_WILLNEED );
+		}
+#endif
+	}
+
+	void MappedChunkAllocator::Unpin( void* chunk, size_t size )
+	{
+#ifdef NEBULA_MAPPED_CHUNKS
+		if( m_file >= 0 )
+		{
+			const size_t mappedSize = GetMappedSize( size );
+			RemoveUnpinned( chunk );
+			m_unpinnedChunks.emplace_front( chunk, mappedSize );
+			m_unpinnedIndices[chunk] = m_unpinnedChunks.begin();
+			m_unpinnedBytes += mappedSize;
+
+			// Only the least recently unpinned chunks beyond the budget are cold
+			while( m_unpinnedBytes > m_residentBytes )
+			{
+				const std::pair<void*, size_t> coldChunk = m_unpinnedChunks.back();
+				RemoveUnpinned( coldChunk.first );
+
+				// The mapping is shared with the file, dropping the pages keeps their contents in the file
+				madvise( coldChunk.first, coldChunk.second, MADV_DONTNEED );
+			}
+		}
+#endif
+	}
+
+	bool MappedChunkAllocator::RemoveUnpinned( void* chunk )
+	{
+		const auto unpinnedIndex = m_unpinnedIndices.find( chunk );
+		if( unpinnedIndex == m_unpinnedIndices.end() )
+		{
+			return false;
+		}
+
+		m_unpinnedBytes -= unpinnedIndex->second->second;
+		m_unpinnedChunks.erase( unpinnedIndex->second );
+		m_unpinnedIndices.erase( unpinnedIndex );
+		return true;
+	}
+}
@@ -0,0 +1,151 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_CHUNKALLOCATOR_H
+#define NEBULA_CHUNKALLOCATOR_H
+
+#include "Constants.h"
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Nebula
+{
+	/*
+	*	Provides the memory behind the chunks of every ComponentPool of a world
+	*	Chunks are pinned while a system iterates them, allocators backed by slower storage use the pins to decide what stays resident
+	*/
+	class ChunkAllocator
+	{
+	public:
+		ChunkAllocator() = default;
+		virtual ~ChunkAllocator() = default;
+
+		/*
+		*	@param	Size:		The size in bytes of the chunk
+		*	@return	void*:		A block aligned to at least COMPONENT_CHUNK_ALIGNMENT, returns nullptr if the memory could not be allocated
+		*/
+		virtual void* Allocate( size_t size ) = 0;
+
+		/*
+		*	Releases a chunk returned by Allocate, with the same size
+		*/
+		virtual void Free( void* chunk, size_t size ) = 0;
+
+		// The chunk is about to be accessed, and must stay resident until it is unpinned
+		virtual void Pin( void*, size_t ) {}
+
+		// The chunk is no longer in use, and may be moved out of memory
+		virtual void Unpin( void*, size_t ) {}
+
+	private:
+		ChunkAllocator( const ChunkAllocator& ) = delete;
+		ChunkAllocator& operator=( const ChunkAllocator& ) = delete;
+		ChunkAllocator( ChunkAllocator&& ) = delete;
+		ChunkAllocator& operator=( ChunkAllocator&& ) = delete;
+	};
+
+	/*
+	*	The default allocator, chunks live on the heap
+	*/
+	class HeapChunkAllocator : public ChunkAllocator
+	{
+	public:
+		void* Allocate( size_t size ) override;
+
+		void Free( void* chunk, size_t size ) override;
+	};
+
+	/*
+	*	Keeps chunks inside of a memory-mapped file, so a world can hold more components than fit in physical memory
+	*	The file is mapped ARENA_SIZE bytes at a time and chunks are carved out of these arenas, keeping the number of mappings low
+	*	The most recently unpinned chunks stay resident up to a budget, older unpinned chunks are handed back to the operating system
+	*	The operating system writes them to the file and reads them back on the next access
+	*	Pinning a chunk asks for it to be read ahead, iterating chunks in order turns into sequential reads of the file
+	*	Only available on POSIX systems, elsewhere, or if the file cannot be created, chunks fall back to the heap
+	*/
+	class MappedChunkAllocator : public ChunkAllocator
+	{
+	public:
+		// The default number of bytes of unpinned chunks kept resident
+		static constexpr size_t DEFAULT_RESIDENT_BYTES = 256 * 1024 * 1024;
+
+		/*
+		*	@param	FilePath:		The file backing the chunks, it is created or truncated, and deleted along with the allocator
+		*	@param	ResidentBytes:	The number of bytes of unpinned chunks kept resident, the least recently unpinned chunks beyond it are handed back
+		*/
+		explicit MappedChunkAllocator( const std::string& filePath, size_t residentBytes = DEFAULT_RESIDENT_BYTES );
+
+		~MappedChunkAllocator() override;
+
+		// Returns false, if the chunks fell back to the heap
+		bool IsMapped() const;
+
+		void* Allocate( size_t size ) override;
+
+		void Free( void* chunk, size_t size ) override;
+
+		void Pin( void* chunk, size_t size ) override;
+
+		void Unpin( void* chunk, size_t size ) override;
+
+	private:
+		// The size in bytes of each region of the file mapped at once, a larger chunk gets an arena of its own size
+		static constexpr size_t ARENA_SIZE = 64 * 1024 * 1024;
+
+		// A region of the file mapped into memory
+		struct Arena
+		{
+			uint8_t*	m_data;
+			size_t		m_size;
+		};
+
+		// The size of a chunk rounded up to whole pages, every chunk starts on a page boundary
+		size_t GetMappedSize( size_t size ) const;
+
+		/*
+		*	Grows the file by a new arena and maps it, chunks are carved out of the new arena from now on
+		*	@param	MinSize:	The size in bytes of the chunk that did not fit into the last arena
+		*	@return	bool:		Returns false, if the file could not be grown or mapped
+		*/
+		bool MapArena( size_t minSize );
+
+		// Forgets the passed chunk if it is one of the resident unpinned chunks, returns false if it is not
+		bool RemoveUnpinned( void* chunk );
+
+		std::string							m_filePath;
+
+		// The file descriptor of the backing file, -1 if the chunks fell back to the heap
+		int									m_file;
+
+		// The size in bytes of the backing file
+		size_t								m_fileSize;
+
+		size_t								m_pageSize;
+
+		// Every mapped region of the file, in the order of their file offsets
+		std::vector<Arena>					m_arenas;
+
+		// The number of bytes of the last arena handed out as chunks
+		size_t								m_arenaUsed;
+
+		// Chunks released by Free, by their mapped size, ready to be handed out again
+		std::unordered_map<size_t, std::vector<void*>>	m_freeChunks;
+
+		// The budget of resident unpinned chunks, in bytes
+		size_t								m_residentBytes;
+
+		// The resident unpinned chunks and their mapped sizes, the most recently unpinned first
+		std::list< std::pair<void*, size_t> >	m_unpinnedChunks;
+
+		// The place of every chunk inside of m_unpinnedChunks
+		std::unordered_map< void*, std::list< std::pair<void*, size_t> >::iterator >	m_unpinnedIndices;
+
+		// The sum of the sizes of m_unpinnedChunks
+		size_t								m_unpinnedBytes;
+	};
+}
+
+#endif // !NEBULA_CHUNKALLOCATOR_H
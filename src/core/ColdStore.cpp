@@ -0,0 +1,130 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#include "ColdStore.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace Nebula
+{
+	ColdStore::ColdStore() :
+		m_records(),
+		m_byteCount( 0 )
+	{}
+
+	void ColdStore::Store( EntityId entityId, const Signature& signature, const std::vector<uint8_t>& bytes, bool bCompress )
+	{
+		Record record;
+		record.m_signature = signature;
+		record.m_size = bytes.size();
+		record.m_bCompressed = false;
+
+		if( bCompress )
+		{
+			Compress( bytes, record.m_bytes );
+			record.m_bCompressed = record.m_bytes.size() < bytes.size();
+		}
+
+		if( !record.m_bCompressed )
+		{
+			record.m_bytes = bytes;
+		}
+		record.m_bytes.shrink_to_fit();
+
+		const auto existing = m_records.find( entityId );
+		if( existing != m_records.end() )
+		{
+			m_byteCount -= existing->second.m_bytes.size();
+			m_records.erase( existing );
+		}
+
+		m_byteCount += record.m_bytes.size();
+		m_records.emplace( entityId, std::move( record ) );
+	}
+
+	bool ColdStore::Take( EntityId entityId, Signature& signature, std::vector<uint8_t>& bytes )
+	{
+		const auto record = m_records.find( entityId );
+		if( record == m_records.end() )
+		{
+			return false;
+		}
+
+		signature = record->second.m_signature;
+		m_byteCount -= record->second.m_bytes.size();
+
+		if( record->second.m_bCompressed )
+		{
+			Decompress( record->second.m_bytes, record->second.m_size, bytes );
+		}
+		else
+		{
+			bytes = std::move( record->second.m_bytes );
+		}
+
+		m_records.erase( record );
+
+		return true;
+	}
+
+	void ColdStore::Compress( const std::vector<uint8_t>& bytes, std::vector<uint8_t>& compressed )
+	{
+		compressed.clear();
+
+		const size_t size = bytes.size();
+		size_t i = 0;
+		while( i < size )
+		{
+			// Runs of 3 to 130 equal bytes are repeated
+			size_t run = 1;
+			while( i + run < size && run < 130 && bytes[i + run] == bytes[i] )
+			{
+				++run;
+			}
+
+			if( run >= 3 )
+			{
+				compressed.push_back( static_cast<uint8_t>( run + 125 ) );
+				compressed.push_back( bytes[i] );
+				i += run;
+				continue;
+			}
+
+			// Everything up to the next run, at most 128 bytes, is copied as it is
+			const size_t literalStart = i;
+			while( i < size && i - literalStart < 128 )
+			{
+				if( i + 2 < size && bytes[i] == bytes[i + 1] && bytes[i] == bytes[i + 2] )
+				{
+					break;
+				}
+				++i;
+			}
+
+			compressed.push_back( static_cast<uint8_t>( i - literalStart - 1 ) );
+			compressed.insert( compressed.end(), bytes.begin() + literalStart, bytes.begin() + i );
+		}
+	}
+
+	void ColdStore::Decompress( const std::vector<uint8_t>& compressed, size_t size, std::vector<uint8_t>& bytes )
+	{
+		bytes.clear();
+		bytes.reserve( size );
+
+		size_t i = 0;
+		while( i < compressed.size() )
+		{
+			const uint8_t control = compressed[i++];
+			if( control < 128 )
+			{
+				const size_t count = std::min<size_t>( control + 1, compressed.size() - i );
+				bytes.insert( bytes.end(), compressed.begin() + i, compressed.begin() + i + count );
+				i += count;
+			}
+			else if( i < compressed.size() )
+			{
+				bytes.insert( bytes.end(), static_cast<size_t>( control ) - 125, compressed[i++] );
+			}
+		}
+	}
+}
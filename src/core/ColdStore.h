@@ -0,0 +1,73 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_COLDSTORE_H
+#define NEBULA_COLDSTORE_H
+
+#include "Constants.h"
+#include "Signature.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace Nebula
+{
+	/*
+	*	Holds the signature and component bytes of every hibernating entity, see ComponentManager::Hibernate
+	*	Records can be compressed with run-length encoding, which suits components full of zeroes and repeated values
+	*/
+	class ColdStore
+	{
+	public:
+		ColdStore();
+
+		/*
+		*	Stores the record of the passed entity, replacing any previous record
+		*	@param	Signature:	The components and tags of the entity before it hibernated
+		*	@param	Bytes:		The bytes of the entity's trivially copyable components, in the order of their signature index
+		*	@param	bCompress:	Compresses the bytes, they are stored as they are if compression does not make them smaller
+		*/
+		void Store( EntityId entityId, const Signature& signature, const std::vector<uint8_t>& bytes, bool bCompress );
+
+		/*
+		*	Removes the record of the passed entity
+		*	@param	Signature:	Receives the stored signature
+		*	@param	Bytes:		Receives the stored bytes, decompressed
+		*	@return	bool:		Returns false, if the entity has no record
+		*/
+		bool Take( EntityId entityId, Signature& signature, std::vector<uint8_t>& bytes );
+
+		inline bool Contains( EntityId entityId ) const { return m_records.find( entityId ) != m_records.end(); }
+
+		// The number of stored records
+		inline size_t GetSize() const { return m_records.size(); }
+
+		// The number of bytes held by the records, after compression
+		inline size_t GetByteCount() const { return m_byteCount; }
+
+	private:
+		struct Record
+		{
+			Signature				m_signature;
+
+			std::vector<uint8_t>	m_bytes;
+
+			// The size of the bytes before compression, equal to the size of 'm_bytes' if they were not compressed
+			size_t					m_size;
+
+			bool					m_bCompressed;
+		};
+
+		/*
+		*	PackBits encoding, a control byte n < 128 is followed by n + 1 literal bytes, n >= 128 repeats the next byte n - 125 times
+		*/
+		static void Compress( const std::vector<uint8_t>& bytes, std::vector<uint8_t>& compressed );
+
+		static void Decompress( const std::vector<uint8_t>& compressed, size_t size, std::vector<uint8_t>& bytes );
+
+		std::unordered_map<EntityId, Record>	m_records;
+
+		size_t									m_byteCount;
+	};
+}
+
+#endif // !NEBULA_COLDSTORE_H
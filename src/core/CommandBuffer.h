@@ -0,0 +1,173 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_COMMANDBUFFER_H
+#define NEBULA_COMMANDBUFFER_H
+
+#include "Constants.h"
+#include "Component.h"
+#include "EntityManager.h"
+#include "ComponentManager.h"
+
+#include "../utility/TemplateHelper.h"
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Nebula
+{
+	/*
+	*	Records entity changes made by a single thread, they are applied to the world at its next sync point, see World::FlushCommandBuffers
+	*	Entities created through a command buffer get their EntityId right away, but only exist once the buffer has been flushed
+	*/
+	class CommandBuffer
+	{
+		friend class World;
+
+		// A single recorded change
+		struct ICommand
+		{
+			virtual ~ICommand() = default;
+
+			virtual void Execute( EntityManager& entityManager, ComponentManager& componentManager ) = 0;
+		};
+
+		struct DestroyEntityCommand : public ICommand
+		{
+			explicit DestroyEntityCommand( EntityId entityId ) : m_entityId( entityId ) {}
+
+			void Execute( EntityManager& entityManager, ComponentManager& componentManager ) override
+			{
+				componentManager.MarkComponentsForCleanUp( m_entityId );
+				entityManager.MarkEntityForCleanUp( m_entityId );
+			}
+
+			EntityId	m_entityId;
+		};
+
+		// The component is constructed when it is recorded, and moved into its pool when the buffer is flushed
+		template<typename T>
+		struct AddComponentCommand : public ICommand
+		{
+			template<typename ... Args>
+			AddComponentCommand( EntityId entityId, std::true_type, Args&& ... args ) :
+				m_entityId( entityId ),
+				m_component( std::forward<Args>( args ) ... )
+			{}
+
+			template<typename ... Args>
+			AddComponentCommand( EntityId entityId, std::false_type, Args&& ... args ) :
+				m_entityId( entityId ),
+				m_component{ std::forward<Args>( args ) ... }
+			{}
+
+			void Execute( EntityManager&, ComponentManager& componentManager ) override
+			{
+				componentManager.AddComponent<T>( m_entityId, std::move( m_component ) );
+			}
+
+			EntityId	m_entityId;
+			T			m_component;
+		};
+
+		template<typename T>
+		struct AddTagCommand : public ICommand
+		{
+			explicit AddTagCommand( EntityId entityId ) : m_entityId( entityId ) {}
+
+			void Execute( EntityManager&, ComponentManager& componentManager ) override
+			{
+				componentManager.AddTag<T>( m_entityId );
+			}
+
+			EntityId	m_entityId;
+		};
+
+		// Reserves the EntityIds of created entities
+		EntityManager*							m_entityManager;
+
+		// The entities reserved by this buffer
+		std::vector<EntityId>					m_createdEntities;
+
+		// The recorded changes, in the order they were recorded
+		std::vector< std::unique_ptr<ICommand> >	m_commands;
+
+	public:
+		explicit CommandBuffer( EntityManager* entityManager ) :
+			m_entityManager( entityManager ),
+			m_createdEntities(),
+			m_commands()
+		{}
+
+		/*
+		*	Reserves an EntityId for an entity that will be created when this buffer is flushed
+		*	@return	EntityId:	The EntityId of the entity, 0 if the entity limit has been reached
+		*/
+		EntityId CreateEntity()
+		{
+			const EntityId entityId = m_entityManager->ReserveEntityId();
+
+			if( entityId != 0 )
+			{
+				m_createdEntities.push_back( entityId );
+			}
+
+			return entityId;
+		}
+
+		// Destroys the entity when this buffer is flushed
+		void DestroyEntity( EntityId entityId )
+		{
+			m_commands.emplace_back( new DestroyEntityCommand( entityId ) );
+		}
+
+		// Constructs a component from the passed arguments, which is added to the entity when this buffer is flushed
+		template<typename T, typename ... Args>
+		void AddComponent( EntityId entityId, Args&& ... args )
+		{
+			static_assert( IsComponent<T>::value, "Components must derive from Component or be trivially copyable" );
+
+			m_commands.emplace_back( new AddComponentCommand<T>( entityId, std::is_constructible<T, Args ...>(), std::forward<Args>( args ) ... ) );
+		}
+
+		// Adds the tag to the entity when this buffer is flushed
+		template<typename T>
+		void AddTag( EntityId entityId )
+		{
+			CanConvert_From<T, Tag>();
+
+			m_commands.emplace_back( new AddTagCommand<T>( entityId ) );
+		}
+
+		inline bool IsEmpty() const { return m_createdEntities.empty() && m_commands.empty(); }
+
+	private:
+		CommandBuffer( const CommandBuffer& ) = delete;
+		CommandBuffer& operator=( const CommandBuffer& ) = delete;
+		CommandBuffer( CommandBuffer&& ) = delete;
+		CommandBuffer& operator=( CommandBuffer&& ) = delete;
+
+		// Creates the reserved entities, the entities of every buffer are created before any buffer's changes are applied
+		void CreateEntities( EntityManager& entityManager )
+		{
+			for( const EntityId entityId : m_createdEntities )
+			{
+				entityManager.CreateReservedEntity( entityId );
+			}
+			m_createdEntities.clear();
+		}
+
+		// Applies every recorded change, in the order it was recorded
+		void ExecuteCommands( EntityManager& entityManager, ComponentManager& componentManager )
+		{
+			for( auto& command : m_commands )
+			{
+				command->Execute( entityManager, componentManager );
+			}
+			m_commands.clear();
+		}
+	};
+}
+
+#endif // !NEBULA_COMMANDBUFFER_H
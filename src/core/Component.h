@@ -5,24 +5,28 @@
 
 #include "Constants.h"
 
+#include <type_traits>
+
 namespace Nebula
 {
+	template<typename T>
+	struct ComponentChecksum;
+
 	class Component
 	{
-		Component(const Component &) = delete;
-		Component(Component &&) = delete;
-		Component& operator=( const Component& ) = delete;
-		Component &operator=(Component &&) = delete;
-
 		friend class ComponentManager;
 
+		// Skips the bookkeeping when hashing components
+		template<typename T>
+		friend struct ComponentChecksum;
+
 		// The owning entity's id
 		EntityId m_ownerId;
 
 		// The unique identier for this component
 		ComponentId m_componentId;
 
-		// The unique identier for this component, used only by the component manager
+		// The index of this component inside of its ComponentPool, used only by the component manager
 		uint64_t m_componentManagerId;
 
 		// This component's unique type identifier
@@ -46,6 +50,42 @@ namespace Nebula
 		inline const ComponentId &GetComponentId() const { return m_componentId; }
 
 		inline const uint64_t &GetComponentType() const { return m_componentType; }
+
+	protected:
+		// Components are moved between the slots of their ComponentPool, along with their bookkeeping
+		Component(const Component &) = default;
+		Component(Component &&) = default;
+		Component& operator=( const Component& ) = default;
+		Component &operator=(Component &&) = default;
+	};
+
+	/*
+	*	Base for data-less marker types, i.e. 'Dead' or 'Selected'
+	*	A Tag is never allocated, it only exists as a bit inside of its entity's signature
+	*/
+	struct Tag {};
+
+	/*
+	*	Marks an entity as a prototype for World::Instantiate
+	*	Prefabs are left out of systems and groups, unless a query asks for them with With<Prefab>
+	*/
+	struct Prefab : public Tag {};
+
+	/*
+	*	Set by ComponentManager::Hibernate on entities whose components are kept in cold storage, it is their only signature bit until they wake
+	*	Hibernating entities are left out of systems, unless a query asks for them with With<Hibernating>
+	*/
+	struct Hibernating : public Tag {};
+
+	/*
+	*	Components either derive from Component, or are plain trivially copyable structs, i.e. struct Position { float x, y, z; };
+	*	Plain structs carry no bookkeeping, only their ComponentPool knows their owner, they are never part of Entity::GetComponents()
+	*	DynamicBuffer components are plain components as well, see DynamicBuffer.h
+	*/
+	template<typename T>
+	struct IsComponent
+	{
+		static constexpr bool value = !std::is_base_of<Tag, T>::value && ( std::is_base_of<Component, T>::value || std::is_trivially_copyable<T>::value );
 	};
 
 }
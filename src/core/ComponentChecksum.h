@@ -0,0 +1,102 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_COMPONENTCHECKSUM_H
+#define NEBULA_COMPONENTCHECKSUM_H
+
+#include "Constants.h"
+#include "Component.h"
+#include "Reflection.h"
+
+#include "../utility/CompilerHash.h"
+
+#include <type_traits>
+
+namespace Nebula
+{
+	/*
+	*	Feeds the state of components of type <T> into the CRC32 of their chunk, see IComponentPool::GetChecksum
+	*	Types listing their fields with NEBULA_REFLECT are hashed field by field, leaving out padding, bookkeeping and fields that are not trivially copyable
+	*	Other plain components are hashed byte by byte, a whole run of them at once
+	*	Other components deriving from Component are hashed from the end of the Component bookkeeping, which differs between peers
+	*	Hashed bytes must mean the same on every peer, fully initialize unreflected components, padding included, and specialise this for types holding pointers
+	*	@param	<T>:	The component type
+	*/
+	template<typename T>
+	struct ComponentChecksum
+	{
+		/*
+		*	@param	Crc:			The running CRC32 of the chunk
+		*	@param	Components:		The first of 'count' contiguous components
+		*	@return	uint32_t:		The CRC32 continued over the components
+		*/
+		static uint32_t Update( uint32_t crc, const T* components, size_t count )
+		{
+			return Update( crc, components, count, std::integral_constant<bool, ComponentReflection<T>::bReflected>(), std::is_base_of<Component, T>() );
+		}
+
+	private:
+		template<typename IsDerived>
+		static uint32_t Update( uint32_t crc, const T* components, size_t count, std::true_type, IsDerived )
+		{
+			const ComponentDescriptor& descriptor = ComponentReflection<T>::GetDescriptor();
+
+			// Fields covering every byte of a plain component leave no padding to skip
+			static const bool bDense = IsDense( descriptor );
+			if( bDense )
+			{
+				return crc32_update( components, count * sizeof( T ), crc );
+			}
+
+			for( size_t i = 0; i < count; ++i )
+			{
+				const uint8_t* bytes = reinterpret_cast<const uint8_t*>( &components[i] );
+				for( size_t f = 0; f < descriptor.m_fieldCount; ++f )
+				{
+					const FieldDescriptor& field = descriptor.m_fields[f];
+					if( field.m_bTriviallyCopyable )
+					{
+						crc = crc32_update( bytes + field.m_offset, field.m_size, crc );
+					}
+				}
+			}
+			return crc;
+		}
+
+		static uint32_t Update( uint32_t crc, const T* components, size_t count, std::false_type, std::false_type )
+		{
+			return crc32_update( components, count * sizeof( T ), crc );
+		}
+
+		static uint32_t Update( uint32_t crc, const T* components, size_t count, std::false_type, std::true_type )
+		{
+			for( size_t i = 0; i < count; ++i )
+			{
+				const Component& header = components[i];
+
+				// Members of <T> may be placed inside of the tail padding of Component, start right after its last member
+				const uint8_t* bytes = reinterpret_cast<const uint8_t*>( &components[i] );
+				const size_t first = static_cast<size_t>( reinterpret_cast<const uint8_t*>( &header.m_bMarkedForCleanUp ) + sizeof( bool ) - bytes );
+
+				crc = crc32_update( bytes + first, sizeof( T ) - first, crc );
+			}
+			return crc;
+		}
+
+		// Returns true, if the fields of a trivially copyable type follow each other in order, from the first byte to the last
+		static bool IsDense( const ComponentDescriptor& descriptor )
+		{
+			size_t end = 0;
+			for( size_t f = 0; f < descriptor.m_fieldCount; ++f )
+			{
+				if( descriptor.m_fields[f].m_offset != end )
+				{
+					return false;
+				}
+				end += descriptor.m_fields[f].m_size;
+			}
+			return descriptor.m_bTriviallyCopyable && end == descriptor.m_size;
+		}
+	};
+}
+
+#endif // !NEBULA_COMPONENTCHECKSUM_H
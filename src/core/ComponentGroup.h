@@ -0,0 +1,61 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_COMPONENTGROUP_H
+#define NEBULA_COMPONENTGROUP_H
+
+#include "Signature.h"
+#include "ComponentPool.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace Nebula
+{
+	/*
+	*	An owning group keeps the entities that have all of its component types packed at the front of each of its pools, in the same order
+	*	For every index i below GetSize(), index i of every owned pool holds a component of the same entity
+	*	The group is kept up to date by the ComponentManager as components are added and removed, a pool can only be owned by one group
+	*/
+	class ComponentGroup
+	{
+		friend class ComponentManager;
+
+		// The component types owned by this group
+		Signature						m_mask;
+
+		// The pools owned by this group
+		std::vector<IComponentPool*>	m_pools;
+
+		// The number of entities in this group, which occupy the first m_size indices of every owned pool
+		size_t							m_size;
+
+	public:
+		ComponentGroup( const Signature& mask, const std::vector<IComponentPool*>& pools ) :
+			m_mask( mask ),
+			m_pools( pools ),
+			m_size( 0 )
+		{}
+
+		inline size_t GetSize() const { return m_size; }
+
+		inline const Signature& GetMask() const { return m_mask; }
+
+		inline bool Contains( EntityId entityId ) const
+		{
+			return !m_pools.empty() && m_pools[0]->GetIndex( entityId ) < m_size;
+		}
+
+		inline bool Owns( const IComponentPool* pool ) const
+		{
+			return std::find( m_pools.begin(), m_pools.end(), pool ) != m_pools.end();
+		}
+
+	private:
+		ComponentGroup( const ComponentGroup& ) = delete;
+		ComponentGroup& operator=( const ComponentGroup& ) = delete;
+		ComponentGroup( ComponentGroup&& ) = delete;
+		ComponentGroup& operator=( ComponentGroup&& ) = delete;
+	};
+}
+
+#endif // !NEBULA_COMPONENTGROUP_H
@@ -2,134 +2,837 @@
 
 #include "ComponentManager.h"
 
+#include <algorithm>
+
 namespace Nebula
 {
-	ComponentManager::ComponentManager( EntityManager* entityManager, SystemManager* systemManager ) :
-				m_components(),
+	constexpr uint32_t IComponentPool::INVALID_INDEX;
+	constexpr size_t ComponentManager::INVALID_CHUNK;
+
+	ComponentManager::ComponentManager( EntityManager* entityManager, SystemManager* systemManager, const WorldLimits& limits ) :
+				m_pools(),
+				m_poolsByTypeKey(),
+				m_chunkAllocator( new HeapChunkAllocator() ),
+				m_snapshots(),
 				m_componentCounter( 0 ),
+				m_batchDepth( 0 ),
+				m_batchedEntities(),
 				m_entityManager( entityManager ),
-				m_systemManager( systemManager )
+				m_systemManager( systemManager ),
+				m_limits( limits )
 	{}
 	
 	ComponentManager::~ComponentManager()
 	{
-		RemoveAllComponentsOnManager();
-		CleanUpComponents();
+		for( auto* group : m_groups )
+		{
+			delete group;
+		}
+		m_groups.clear();
+
+		for( auto* fieldIndex : m_fieldIndices )
+		{
+			delete fieldIndex;
+		}
+		m_fieldIndices.clear();
+
+		for( auto* snapshot : m_snapshots )
+		{
+			delete snapshot;
+		}
+		m_snapshots.clear();
+
+		// Destroying a pool destroys all of the components inside of it
+		for( auto* pool : m_pools )
+		{
+			delete pool;
+		}
+		m_pools.clear();
+		m_poolsByTypeKey.clear();
+
+		// The pools have returned their chunks
+		delete m_chunkAllocator;
+		m_chunkAllocator = nullptr;
 	}
 
 	void ComponentManager::RemoveAllComponents( EntityId entityId )
 	{
-		Entity* entity = m_entityManager->m_entities[entityId];
+		Entity* entity = GetEntity( entityId );
 		if( entity == nullptr )	// Entity does not exist
 		{
 			return;
 		}
 
-		for( auto* c : entity->GetComponents() )
+		if( IsHibernating( *entity ) )
 		{
-			if( c != nullptr )
-			{
-				RemoveComponent( *entity, c->m_componentType );
-			}
-			else // The moment we find a null component, we now we are at the end of the array, no need to continue
+			DiscardHibernatingComponents( *entity );
+		}
+
+		const Signature signature = entity->m_signature;
+
+		// All components and tags are leaving the entity
+		entity->m_signature.reset();
+
+		LeaveAllGroups( entityId );
+		RefreshIndices( *entity );
+
+		entity->m_components.clear();
+		this->m_componentCounter -= CountComponents( signature );
+		entity->m_componentCounter = 0;
+
+		if( m_systemManager )
+		{
+			// The entity leaves its systems once, before its components are destroyed
+			m_systemManager->OnEntitySignatureChanged( *entity );
+		}
+
+		for( size_t i = 0; i < m_pools.size(); ++i )
+		{
+			if( m_pools[i] != nullptr && signature.test( i ) )
 			{
-				break;
+				RemoveFromPool( m_pools[i], entityId );
 			}
 		}
 	}
 
-	void ComponentManager::RemoveAllComponentsOnManager()
+	void ComponentManager::MarkComponentsForCleanUp( EntityId entityId )
 	{
-		for( size_t i = 0; i < m_components.size(); i++ )
+		Entity* entity = GetEntity( entityId );
+		if( entity == nullptr )	// Entity does not exist
+		{
+			return;
+		}
+
+		if( IsHibernating( *entity ) )
+		{
+			DiscardHibernatingComponents( *entity );
+		}
+
+		const Signature signature = entity->m_signature;
+		entity->m_signature.reset();
+
+		// The components stay in their pools until clean up, but must not be part of any group in the meantime
+		LeaveAllGroups( entityId );
+		RefreshIndices( *entity );
+
+		entity->m_components.clear();
+		this->m_componentCounter -= CountComponents( signature );
+		entity->m_componentCounter = 0;
+
+		if( m_systemManager )
+		{
+			m_systemManager->OnEntitySignatureChanged( *entity );
+		}
+	}
+
+	size_t ComponentManager::Hibernate( const std::vector<EntityId>& entities, bool bCompress )
+	{
+		std::vector<Entity*> hibernating;
+		std::vector<Signature> signatures;
+		for( const EntityId entityId : entities )
+		{
+			// Prefabs stay in place, Instantiate copies from their pools
+			Entity* entity = GetEntity( entityId );
+			if( entity == nullptr || IsHibernating( *entity ) || entity->m_signature.test( GetSignatureIndex<Prefab>() ) )
+			{
+				continue;
+			}
+
+			hibernating.push_back( entity );
+			signatures.push_back( entity->m_signature );
+
+			// The entity leaves its groups and indices while its components are still in place
+			NotifyHibernation( entityId, entity->m_signature, true );
+			entity->m_signature.reset();
+			entity->m_signature.set( GetSignatureIndex<Hibernating>() );
+			LeaveAllGroups( entityId );
+			RefreshIndices( *entity );
+
+			entity->m_components.clear();
+			this->m_componentCounter -= CountComponents( signatures.back() );
+			entity->m_componentCounter = 0;
+		}
+
+		if( hibernating.empty() )
+		{
+			return 0;
+		}
+
+		if( m_systemManager )
+		{
+			// Every system drops the hibernating entities at once
+			m_systemManager->OnEntitiesSignatureChanged( hibernating );
+		}
+
+		std::vector<uint8_t> bytes;
+		for( size_t e = 0; e < hibernating.size(); ++e )
 		{
+			const EntityId entityId = hibernating[e]->m_entityId;
 
-			if( m_components[i] != nullptr )
+			bytes.clear();
+			for( size_t i = 0; i < m_pools.size(); ++i )
 			{
-				MarkComponentForCleanUp( m_components[i] );
+				IComponentPool* pool = m_pools[i];
+				if( pool != nullptr && signatures[e].test( i ) )
+				{
+					pool->Freeze( pool->GetIndex( entityId ), bytes );
+					RemoveFromPool( pool, entityId );
+				}
 			}
 
+			m_coldStore.Store( entityId, signatures[e], bytes, bCompress );
 		}
 
-		m_componentMap.clear();
+		return hibernating.size();
 	}
 
-	void ComponentManager::RemoveComponent( const Entity& entity, const uint64_t& componentType )
+	size_t ComponentManager::Wake( const std::vector<EntityId>& entities )
 	{
-		// Loop through the components of the same type, the id of the component type is used as the key to a vector of components 
-		Component* component = nullptr;
-		size_t size = m_componentMap[componentType].size();
-		for( size_t i = 0; i < size; i++ )	// Iterator through vector of components from the same type
+		std::vector<Entity*> woken;
+		std::vector<uint8_t> bytes;
+		for( const EntityId entityId : entities )
 		{
-			component = m_componentMap[componentType][i];
-
-			if( component == nullptr )
+			Entity* entity = GetEntity( entityId );
+			Signature signature;
+			if( entity == nullptr || !IsHibernating( *entity ) || !m_coldStore.Take( entityId, signature, bytes ) )
 			{
 				continue;
 			}
 
-			if( component->m_ownerId == entity.m_entityId )		// When we find the first component with the same owner, we will remove it
+			// The bytes are laid out in the order of the signature indices of the components
+			const Signature frozenSignature = signature;
+			const uint8_t* cursor = bytes.data();
+			for( size_t i = 0; i < m_pools.size(); ++i )
 			{
+				IComponentPool* pool = m_pools[i];
+				if( pool == nullptr || !signature.test( i ) )
+				{
+					continue;
+				}
+
+				if( !pool->Thaw( entityId, cursor ) )	// The component is lost, along with its bit
+				{
+					signature.reset( i );
+					continue;
+				}
+
+				const uint32_t index = pool->GetIndex( entityId );
+				Component* component = pool->GetComponent( index );
+				if( component != nullptr )
+				{
+					AttachComponent( *entity, component, index, std::true_type() );
+				}
+				++this->m_componentCounter;
+			}
 
-				// Remove the component, from the ComponentMap Vector, replacing the component to be removed with last component in the vector
-				m_componentMap[componentType][i] = m_componentMap[componentType][size - 1];
-				m_componentMap[componentType].pop_back();
+			entity->m_signature = signature;
+			RefreshGroups( *entity );
+			RefreshIndices( *entity );
+			NotifyHibernation( entityId, frozenSignature, false );
 
-				ComponentId componentId = component->m_componentId;
+			woken.push_back( entity );
+		}
 
-				// Removing the reference from the list of components on the passed entity
-				m_entityManager->m_entities[entity.m_entityId]->m_components[componentId] = nullptr;
-				--m_entityManager->m_entities[entity.m_entityId]->m_componentCounter;
+		if( m_systemManager && !woken.empty() )
+		{
+			m_systemManager->OnEntitiesSignatureChanged( woken );
+		}
 
-				// Now we will perform the similar operation for the Component Manager's Array of Components
-				// Just using local function variables that already exist
-				componentId = component->m_componentManagerId;
-				ComponentId lastComponentId = --this->m_componentCounter;
+		return woken.size();
+	}
 
-				// Assign the last component in the array to the removed component's index
-				m_components[componentId] = m_components[lastComponentId];
-				m_components[lastComponentId] = nullptr;
+	bool ComponentManager::IsHibernating( EntityId entityId ) const
+	{
+		const Entity* entity = GetEntity( entityId );
+		return entity != nullptr && IsHibernating( *entity );
+	}
 
-				if( m_components[componentId] != nullptr )
+	void ComponentManager::DiscardHibernatingComponents( Entity& entity )
+	{
+		Signature signature;
+		std::vector<uint8_t> bytes;
+		if( m_coldStore.Take( entity.m_entityId, signature, bytes ) )
+		{
+			const uint8_t* cursor = bytes.data();
+			for( size_t i = 0; i < m_pools.size(); ++i )
+			{
+				if( m_pools[i] != nullptr && signature.test( i ) )
 				{
-					m_components[componentId]->m_componentManagerId = componentId;
+					m_pools[i]->DiscardFrozen( entity.m_entityId, cursor );
 				}
+			}
+
+			NotifyHibernation( entity.m_entityId, signature, false );
+		}
 
-				if( m_systemManager )
+		entity.m_signature.reset();
+	}
+
+	void ComponentManager::NotifyHibernation( EntityId entityId, const Signature& signature, bool bHibernating )
+	{
+		for( size_t i = 0; i < m_pools.size(); ++i )
+		{
+			IComponentPool* pool = m_pools[i];
+			if( pool == nullptr || !signature.test( i ) )
+			{
+				continue;
+			}
+
+			for( auto* fieldIndex : pool->m_fieldIndices )
+			{
+				if( bHibernating )
+				{
+					fieldIndex->OnHibernate( entityId );
+				}
+				else
 				{
-					// Update systems, now that we have removed a component from this entity
-					m_systemManager->OnEntitySignatureChanged( entity );
+					fieldIndex->OnWake( entityId );
 				}
+			}
+		}
+	}
+
+	void ComponentManager::CleanUpComponents( EntityId entityId )
+	{
+		for( auto* pool : m_pools )
+		{
+			if( pool != nullptr && pool->Has( entityId ) )
+			{
+				RemoveFromPool( pool, entityId );
+			}
+		}
+	}
+
+	void ComponentManager::ReleaseUnusedMemory()
+	{
+		for( auto* pool : m_pools )
+		{
+			if( pool != nullptr )
+			{
+				pool->ReleaseUnusedChunks();
+			}
+		}
+	}
+
+	void ComponentManager::PublishSnapshots()
+	{
+		for( auto* snapshot : m_snapshots )
+		{
+			if( snapshot != nullptr )
+			{
+				snapshot->Publish();
+			}
+		}
+	}
+
+	void ComponentManager::EndBatch()
+	{
+		if( m_batchDepth == 0 || --m_batchDepth > 0 )
+		{
+			return;
+		}
+
+		// An entity receiving several components is only matched once
+		std::sort( m_batchedEntities.begin(), m_batchedEntities.end() );
+		m_batchedEntities.erase( std::unique( m_batchedEntities.begin(), m_batchedEntities.end() ), m_batchedEntities.end() );
+
+		std::vector<Entity*> entities;
+		entities.reserve( m_batchedEntities.size() );
+		for( const EntityId entityId : m_batchedEntities )
+		{
+			Entity* entity = GetEntity( entityId );
+			if( entity != nullptr )
+			{
+				entities.push_back( entity );
+			}
+		}
+		m_batchedEntities.clear();
+
+		if( m_systemManager && !entities.empty() )
+		{
+			m_systemManager->OnEntitiesSignatureChanged( entities );
+		}
+	}
+
+	uint32_t ComponentManager::GetChecksum()
+	{
+		uint32_t crc = 0xFFFFFFFF;
+		for( auto* pool : m_poolsByTypeKey )
+		{
+			if( pool->GetSize() == 0 )
+			{
+				continue;
+			}
+
+			const uint64_t typeKey = pool->m_typeKey;
+			const uint32_t checksum = pool->GetChecksum();
+			crc = crc32_update( &typeKey, sizeof( typeKey ), crc );
+			crc = crc32_update( &checksum, sizeof( checksum ), crc );
+		}
+
+		return crc ^ 0xFFFFFFFF;
+	}
+
+	void ComponentManager::GetPoolChecksums( std::vector< std::pair<uint64_t, uint32_t> >& checksums )
+	{
+		// Like GetChecksum, types without components are left out, whether or not a peer ever used them
+		checksums.clear();
+		for( auto* pool : m_poolsByTypeKey )
+		{
+			const uint32_t checksum = pool->GetChecksum();
+			if( pool->GetSize() != 0 )
+			{
+				checksums.emplace_back( pool->m_typeKey, checksum );
+			}
+		}
+	}
+
+	const std::vector<uint32_t>* ComponentManager::GetChunkChecksums( uint64_t typeKey ) const
+	{
+		const IComponentPool* pool = FindPoolByTypeKey( typeKey );
+		return pool != nullptr ? &pool->GetChunkChecksums() : nullptr;
+	}
+
+	const ComponentDescriptor* ComponentManager::FindDescriptor( size_t signatureIndex ) const
+	{
+		return signatureIndex < m_pools.size() && m_pools[signatureIndex] != nullptr ? &m_pools[signatureIndex]->GetDescriptor() : nullptr;
+	}
+
+	size_t ComponentManager::FindDivergingChunk( uint64_t typeKey, const std::vector<uint32_t>& remoteChecksums, std::vector<EntityId>& entities ) const
+	{
+		static const std::vector<uint32_t> none;
+
+		const IComponentPool* pool = FindPoolByTypeKey( typeKey );
+		const std::vector<uint32_t>& localChecksums = pool != nullptr ? pool->GetChunkChecksums() : none;
+
+		// A missing chunk hashes to 0, like an empty one
+		const size_t chunkCount = std::max( localChecksums.size(), remoteChecksums.size() );
+		for( size_t chunk = 0; chunk < chunkCount; ++chunk )
+		{
+			const uint32_t local = chunk < localChecksums.size() ? localChecksums[chunk] : 0;
+			const uint32_t remote = chunk < remoteChecksums.size() ? remoteChecksums[chunk] : 0;
+			if( local == remote )
+			{
+				continue;
+			}
+
+			if( pool != nullptr )
+			{
+				const size_t first = std::min( chunk * COMPONENT_CHUNK_CAPACITY, pool->GetSize() );
+				const size_t last = std::min( first + COMPONENT_CHUNK_CAPACITY, pool->GetSize() );
+				entities.insert( entities.end(), pool->GetEntities().begin() + first, pool->GetEntities().begin() + last );
+			}
+			return chunk;
+		}
+
+		return INVALID_CHUNK;
+	}
 
-				MarkComponentForCleanUp( component );
+	bool ComponentManager::SetChunkAllocator( ChunkAllocator* allocator )
+	{
+		if( allocator == nullptr )
+		{
+			return false;
+		}
 
-				break;
+		for( auto* pool : m_pools )
+		{
+			if( pool != nullptr )	// Chunks cannot be moved between allocators
+			{
+				return false;
 			}
 		}
+
+		delete m_chunkAllocator;
+		m_chunkAllocator = allocator;
+
+		return true;
+	}
+
+	Entity* ComponentManager::GetEntity( EntityId entityId ) const
+	{
+		const auto it = m_entityManager->m_entities.find( entityId );
+		return it != m_entityManager->m_entities.end() ? it->second : nullptr;
+	}
+
+	void ComponentManager::AddPoolByTypeKey( IComponentPool* pool )
+	{
+		const auto it = std::lower_bound( m_poolsByTypeKey.begin(), m_poolsByTypeKey.end(), pool->m_typeKey,
+			[]( const IComponentPool* other, uint64_t typeKey ) { return other->m_typeKey < typeKey; } );
+		m_poolsByTypeKey.insert( it, pool );
+	}
+
+	IComponentPool* ComponentManager::FindPoolByTypeKey( uint64_t typeKey ) const
+	{
+		const auto it = std::lower_bound( m_poolsByTypeKey.begin(), m_poolsByTypeKey.end(), typeKey,
+			[]( const IComponentPool* other, uint64_t key ) { return other->m_typeKey < key; } );
+		return it != m_poolsByTypeKey.end() && ( *it )->m_typeKey == typeKey ? *it : nullptr;
+	}
+
+	void ComponentManager::GetLiveEntities( std::vector<Entity*>& entities ) const
+	{
+		entities.reserve( entities.size() + m_entityManager->m_entities.size() );
+		for( const auto& entity : m_entityManager->m_entities )
+		{
+			entities.push_back( entity.second );
+		}
 	}
 
-	void ComponentManager::MarkComponentForCleanUp( Component* component )
+	void ComponentManager::RemoveFromPool( IComponentPool* pool, EntityId entityId )
 	{
-		if( component == nullptr )
+		const EntityId relocatedEntityId = pool->Remove( entityId );
+
+		if( relocatedEntityId == 0 )	// The removed component was the last in the pool, nothing was moved
 		{
 			return;
 		}
 
-		component->m_bMarkedForCleanUp = true;
-		m_componentsMarkedForCleanUp.push_back( component );
+		OnComponentRelocated( pool, pool->GetIndex( relocatedEntityId ) );
+	}
+
+	size_t ComponentManager::CountComponents( const Signature& signature ) const
+	{
+		size_t count = 0;
+		for( size_t i = 0; i < m_pools.size(); ++i )
+		{
+			if( m_pools[i] != nullptr && signature.test( i ) )
+			{
+				++count;
+			}
+		}
+		return count;
+	}
+
+	void ComponentManager::OnComponentRelocated( IComponentPool* pool, uint32_t index )
+	{
+		Component* component = pool->GetComponent( index );
+		if( component != nullptr )	// Plain components have no bookkeeping to update
+		{
+			component->m_componentManagerId = index;
+
+			// Entities whose components are being cleaned up or frozen have already let go of them
+			Entity* entity = GetEntity( component->m_ownerId );
+			if( entity != nullptr && component->m_componentId < entity->m_components.size() )
+			{
+				entity->m_components[component->m_componentId] = component;
+			}
+		}
+
+		// The signature is unchanged, only the systems holding this component type must point to its new place
+		if( m_systemManager && pool->m_signatureIndex < MAX_COMPONENT_TYPES )
+		{
+			m_systemManager->OnComponentRelocated( pool->GetEntities()[index], pool->m_signatureIndex );
+		}
+	}
+
+	void ComponentManager::ReleasePackedPools( const void* owner )
+	{
+		for( auto* pool : m_pools )
+		{
+			if( pool != nullptr && pool->m_packOwner == owner )
+			{
+				pool->m_packOwner = nullptr;
+			}
+		}
 	}
 
-	void ComponentManager::CleanUpComponents()
+	void ComponentManager::PackPool( IComponentPool* pool, const std::vector<EntityId>& entities )
 	{
-		size_t size = m_componentsMarkedForCleanUp.size();
+		const size_t size = entities.size();
 		for( size_t i = 0; i < size; ++i )
 		{
-			if( m_componentsMarkedForCleanUp[i] != nullptr )
+			const uint32_t index = pool->GetIndex( entities[i] );
+
+			if( index == IComponentPool::INVALID_INDEX )	// The entity has no component to pack
+			{
+				continue;
+			}
+
+			SwapComponents( pool, static_cast<uint32_t>( i ), index );
+		}
+	}
+
+	void ComponentManager::SwapComponents( IComponentPool* pool, uint32_t first, uint32_t second )
+	{
+		if( first == second )
+		{
+			return;
+		}
+
+		pool->SwapElements( first, second );
+
+		OnComponentRelocated( pool, first );
+		OnComponentRelocated( pool, second );
+	}
+
+	ComponentGroup* ComponentManager::CreateGroup( const Signature& mask, const std::vector<IComponentPool*>& pools )
+	{
+		for( auto* pool : pools )
+		{
+			if( pool == nullptr )	// A component type that cannot be represented in a signature
+			{
+				return nullptr;
+			}
+
+			if( pool->m_group != nullptr )
+			{
+				// Systems with the same signature can share a group, any other overlap would fight over the order of the pool
+				return pool->m_group->m_mask == mask ? pool->m_group : nullptr;
+			}
+		}
+
+		if( pools.empty() )
+		{
+			return nullptr;
+		}
+
+		ComponentGroup* group = new ComponentGroup( mask, pools );
+		m_groups.push_back( group );
+
+		for( auto* pool : pools )
+		{
+			pool->m_group = group;
+		}
+
+		// Gather the entities that already have every component of the group
+		const std::vector<EntityId> candidates = pools[0]->GetEntities();
+		for( const EntityId entityId : candidates )
+		{
+			Entity* entity = GetEntity( entityId );
+			if( entity != nullptr )
+			{
+				JoinGroup( *group, *entity );
+			}
+		}
+
+		return group;
+	}
+
+	void ComponentManager::JoinGroup( ComponentGroup& group, const Entity& entity )
+	{
+		if( ( entity.m_signature & group.m_mask ) != group.m_mask || entity.m_signature.test( GetSignatureIndex<Prefab>() ) || group.Contains( entity.m_entityId ) )
+		{
+			return;
+		}
+
+		// The entity takes the first index past the end of the group in every owned pool
+		const uint32_t groupEnd = static_cast<uint32_t>( group.m_size );
+		for( auto* pool : group.m_pools )
+		{
+			SwapComponents( pool, pool->GetIndex( entity.m_entityId ), groupEnd );
+		}
+		++group.m_size;
+	}
+
+	void ComponentManager::LeaveGroup( ComponentGroup& group, EntityId entityId )
+	{
+		if( !group.Contains( entityId ) )
+		{
+			return;
+		}
+
+		// The entity swaps places with the last entity of the group in every owned pool
+		const uint32_t groupLast = static_cast<uint32_t>( group.m_size - 1 );
+		for( auto* pool : group.m_pools )
+		{
+			SwapComponents( pool, pool->GetIndex( entityId ), groupLast );
+		}
+		--group.m_size;
+	}
+
+	void ComponentManager::LeaveAllGroups( EntityId entityId )
+	{
+		for( auto* group : m_groups )
+		{
+			LeaveGroup( *group, entityId );
+		}
+	}
+
+	void ComponentManager::RefreshGroups( const Entity& entity )
+	{
+		const bool bPrefab = entity.m_signature.test( GetSignatureIndex<Prefab>() );
+		for( auto* group : m_groups )
+		{
+			if( !bPrefab && ( entity.m_signature & group->m_mask ) == group->m_mask )
+			{
+				JoinGroup( *group, entity );
+			}
+			else
+			{
+				LeaveGroup( *group, entity.m_entityId );
+			}
+		}
+	}
+
+	void ComponentManager::AddFieldIndex( IComponentPool& pool, size_t signatureIndex, IFieldIndex* index )
+	{
+		m_fieldIndices.push_back( index );
+		pool.m_fieldIndices.push_back( index );
+
+		// Components of destroyed entities wait in the pool for clean up, but are no longer part of their signature
+		const size_t prefabIndex = GetSignatureIndex<Prefab>();
+		for( size_t i = 0; i < pool.GetSize(); ++i )
+		{
+			const Entity* entity = GetEntity( pool.m_entities[i] );
+			if( entity != nullptr && entity->m_signature.test( signatureIndex ) && ( index->IndexesPrefabs() || !entity->m_signature.test( prefabIndex ) ) )
+			{
+				index->Insert( entity->m_entityId, pool.GetElement( i ) );
+			}
+		}
+	}
+
+	void ComponentManager::IndexComponent( IComponentPool& pool, const Entity& entity )
+	{
+		const uint32_t index = pool.GetIndex( entity.m_entityId );
+		if( index == IComponentPool::INVALID_INDEX )
+		{
+			return;
+		}
+
+		const bool bPrefab = entity.m_signature.test( GetSignatureIndex<Prefab>() );
+		const void* component = pool.GetElement( index );
+		for( auto* fieldIndex : pool.m_fieldIndices )
+		{
+			if( bPrefab && !fieldIndex->IndexesPrefabs() )
+			{
+				fieldIndex->Erase( entity.m_entityId );
+			}
+			else
+			{
+				fieldIndex->Insert( entity.m_entityId, component );
+			}
+		}
+	}
+
+	void ComponentManager::UnindexComponent( IComponentPool& pool, EntityId entityId )
+	{
+		for( auto* fieldIndex : pool.m_fieldIndices )
+		{
+			fieldIndex->Erase( entityId );
+		}
+	}
+
+	void ComponentManager::RefreshIndices( const Entity& entity )
+	{
+		if( m_fieldIndices.empty() )
+		{
+			return;
+		}
+
+		for( size_t i = 0; i < m_pools.size(); ++i )
+		{
+			IComponentPool* pool = m_pools[i];
+			if( pool == nullptr || pool->m_fieldIndices.empty() )
+			{
+				continue;
+			}
+
+			// Prefabs are left out by the indices themselves
+			if( entity.m_signature.test( i ) )
+			{
+				IndexComponent( *pool, entity );
+			}
+			else
+			{
+				UnindexComponent( *pool, entity.m_entityId );
+			}
+		}
+	}
+
+	bool ComponentManager::Instantiate( EntityId prefabId, const std::vector<EntityId>& entities )
+	{
+		Entity* prefab = GetEntity( prefabId );
+		if( prefab == nullptr || IsHibernating( *prefab ) )	// Prefab does not exist, or its components are in cold storage
+		{
+			return false;
+		}
+
+		// Every component of the prefab must be copied, or the instances would silently miss some of them
+		size_t prefabComponentCount = 0;
+		for( const auto* pool : m_pools )
+		{
+			if( pool != nullptr && pool->Has( prefabId ) )
+			{
+				if( !pool->IsCopyable() )
+				{
+					return false;
+				}
+				++prefabComponentCount;
+			}
+		}
+
+		// An entity passed twice is instantiated once
+		std::vector<EntityId> uniqueIds( entities );
+		std::sort( uniqueIds.begin(), uniqueIds.end() );
+		uniqueIds.erase( std::unique( uniqueIds.begin(), uniqueIds.end() ), uniqueIds.end() );
+
+		std::vector<EntityId> instanceIds;
+		std::vector<Entity*> instances;
+		for( const EntityId entityId : uniqueIds )
+		{
+			Entity* entity = GetEntity( entityId );
+			if( entity != nullptr && entity != prefab && entity->m_componentCounter == 0 && entity->m_signature.none() )
+			{
+				instanceIds.push_back( entityId );
+				instances.push_back( entity );
+			}
+		}
+
+		if( instances.empty() )
+		{
+			return true;
+		}
+
+		if( m_componentCounter + prefabComponentCount * instances.size() > m_limits.m_maxComponents )	// Not every instance would fit
+		{
+			return false;
+		}
+
+		// Tags only live inside of the signature, whatever is left after the prefab's pools are visited
+		Signature tags = prefab->m_signature;
+		tags.reset( GetSignatureIndex<Prefab>() );
+		tags.reset( GetSignatureIndex<Hibernating>() );
+
+		for( size_t signatureIndex = 0; signatureIndex < m_pools.size(); ++signatureIndex )
+		{
+			IComponentPool* pool = m_pools[signatureIndex];
+			if( pool == nullptr || !pool->Has( prefabId ) )
 			{
-				delete m_componentsMarkedForCleanUp[i], m_componentsMarkedForCleanUp[i] = nullptr;
+				continue;
 			}
+			tags.reset( signatureIndex );
+
+			// The copies are appended to the end of the pool, each one is matched to its owner through the pool
+			const size_t firstIndex = pool->GetSize();
+			const size_t clonedCount = pool->Clone( pool->GetIndex( prefabId ), instanceIds );
+
+			for( size_t index = firstIndex; index < firstIndex + clonedCount; ++index )
+			{
+				Component* component = pool->GetComponent( static_cast<uint32_t>( index ) );
+				Entity* entity = GetEntity( pool->GetEntities()[index] );
+
+				if( component != nullptr )
+				{
+					AttachComponent( *entity, component, static_cast<uint32_t>( index ), std::true_type() );
+				}
+				entity->m_signature.set( signatureIndex );
+			}
+			this->m_componentCounter += clonedCount;
+		}
+
+		for( Entity* entity : instances )
+		{
+			entity->m_signature |= tags;
+			RefreshGroups( *entity );
+			RefreshIndices( *entity );
+		}
+
+		if( m_systemManager )
+		{
+			m_systemManager->OnEntitiesSignatureChanged( instances );
 		}
 
-		m_componentsMarkedForCleanUp.clear();
+		return true;
 	}
 
-};
\ No newline at end of file
+};
@@ -5,49 +5,76 @@
 
 #include "../utility/TemplateHelper.h"
 #include "Component.h"
+#include "ComponentPool.h"
+#include "ComponentGroup.h"
+#include "ComponentSnapshot.h"
+#include "FieldIndex.h"
+#include "SharedComponentStore.h"
+#include "ColdStore.h"
 #include "EntityManager.h"
 #include "SystemManager.h"
 
-#include <array>
 #include <vector>
-#include <map>
+#include <type_traits>
 
 namespace Nebula
 {
 	/*
 	*	The Component Manager is responsible for creating, destroying and managing the lifetime of components
 	*	Along with updating System Manager when the signature of an Entity has changed
+	*	Components are stored by value inside of a ComponentPool per component type
 	*/
 	class ComponentManager
 	{
-		// All Components created by this component manager
-		std::array<Component*, MAX_COMPONENTS> m_components;
+		// The storage of each component type, indexed by the signature index of the component type
+		std::vector<IComponentPool*>	m_pools;
 
-		// Components marked for clean up
-		std::vector<Component*> m_componentsMarkedForCleanUp;
+		// The same pools, in increasing order of their type key, the order of the world checksum
+		std::vector<IComponentPool*>	m_poolsByTypeKey;
+
+		// The owning groups created on this component manager
+		std::vector<ComponentGroup*>	m_groups;
+
+		// The field indices created on this component manager
+		std::vector<IFieldIndex*>		m_fieldIndices;
+
+		// The store of each shared component type, indexed by the signature index of its Shared<T> component, owned as field indices
+		std::vector<IFieldIndex*>		m_sharedStores;
+
+		// The components of hibernating entities
+		ColdStore						m_coldStore;
+
+		// Provides the memory of every pool's chunks
+		ChunkAllocator*			m_chunkAllocator;
+
+		// The snapshots of the component types that publish their state, indexed by the signature index of the component type
+		std::vector<ISnapshot*>	m_snapshots;
 
 		// The number of components on this component manager
 		uint64_t				m_componentCounter;
 
+		// The number of open batches, and the entities that received components during them
+		uint32_t				m_batchDepth;
+		std::vector<EntityId>	m_batchedEntities;
+
 		// Entity Manager reference
 		EntityManager* m_entityManager;
 
-		using ComponentMap = std::map< uint64_t /*Component Type*/, std::vector<Component*> /*Components*/ >;
-
-		// Map of Components sorted by the component type, where the component type is a key to a list of components of that type
-		ComponentMap			m_componentMap;
-
 		// System Manager reference
 		SystemManager* m_systemManager;
 
+		// The capacity of the world this component manager belongs to
+		const WorldLimits		m_limits;
+
 	public:
-		explicit ComponentManager( EntityManager* entityManager, SystemManager* systemManager );
+		explicit ComponentManager( EntityManager* entityManager, SystemManager* systemManager, const WorldLimits& limits = WorldLimits() );
 
 		~ComponentManager();
 
 
 		/*
 		*	Adds a component to the entity with the passed EntityId, returning the created <Component>
+		*	The returned component is valid until a component of the same type is removed from any entity
 		*	@param	<T>:		The type of Component that will be created and added to the entity
 		*	@param	EntityId:	The entity id of the entity to add the created component to
 		*	@param	Args:		The constructor requirements for the component
@@ -55,61 +82,105 @@ namespace Nebula
 		template<typename T, typename ... Args>
 		T* AddComponent( EntityId entityId, Args&& ... args )
 		{
-			// Complile-time check to see if class T can be converted to class B, 
-				// valid for derivation check of class T from class B
-			CanConvert_From<T, Component>();
+			static_assert( IsComponent<T>::value, "Components must derive from Component or be trivially copyable" );
 
-			/* '>=' check work here because we increment component count after adding a component, and the counter begins 0 for the first index of the component map */
-			if( m_componentCounter >= MAX_COMPONENTS )	// We are at capacity, return 
+			const size_t signatureIndex = GetSignatureIndex<T>();
+			if( signatureIndex >= MAX_COMPONENT_TYPES )	// This component type cannot be represented in an entity's signature
 			{
 				return nullptr;
 			}
 
-			Entity* entity = m_entityManager->m_entities[entityId];
-			if( entity == nullptr )	// Entity does not exist
+			/* '>=' check work here because we increment component count after adding a component, and the counter begins 0 for the first index of the component map */
+			if( m_componentCounter >= m_limits.m_maxComponents )	// We are at capacity, return 
 			{
 				return nullptr;
 			}
 
-			if( entity->m_componentCounter >= MAX_COMPONENTS_PER_ENTITY )	// This entity is at its capacity
+			Entity* entity = GetEntity( entityId );
+			if( entity == nullptr || IsHibernating( *entity ) )	// Entity does not exist, or its components are in cold storage
 			{
 				return nullptr;
 			}
 
-			if(FindComponent<T>(entityId) != nullptr)
+			if( std::is_base_of<Component, T>::value && entity->m_componentCounter >= m_limits.m_maxComponentsPerEntity )	// This entity is at its capacity
 			{
-				return nullptr;	// Component already exists within the entity
+				return nullptr;
 			}
 
 			// Component Classes can support different constructors, 0 -> n number of parameters in their constructor
-			T* component = new T( std::forward<Args>( args ) ... );
+			// The pool refuses a second component of the same type on the same entity
+			ComponentPool<T>* pool = GetPool<T>();
+			T* component = pool->Emplace( entityId, std::forward<Args>( args ) ... );
 
 			if( component == nullptr )	// Could not create component
 			{
 				return nullptr;
 			}
 
-			component->m_ownerId = entityId;
-			component->m_componentId = entity->m_componentCounter;
-			++entity->m_componentCounter;
-			entity->m_components[component->m_componentId] = component;
-
-			component->m_componentManagerId = this->m_componentCounter;
-			m_components[component->m_componentManagerId] = component;
+			AttachComponent( *entity, component, pool->GetIndex( entityId ), std::is_base_of<Component, T>() );
 			++this->m_componentCounter;
 
-			// Also add a reference of this component to the ComponentMap
-			m_componentMap[T::ID].push_back( component );
+			entity->m_signature.set( signatureIndex );
 
-			if( m_systemManager )
+			if( pool->GetGroup() != nullptr )
+			{
+				// The entity may now have every component of the group owning this pool
+				JoinGroup( *pool->GetGroup(), *entity );
+			}
+
+			if( !pool->GetFieldIndices().empty() )
+			{
+				IndexComponent( *pool, *entity );
+			}
+
+			if( m_batchDepth > 0 )
+			{
+				// The systems see the entity once the batch ends
+				m_batchedEntities.push_back( entityId );
+			}
+			else if( m_systemManager )
 			{
 				// This entity's signature has now changed update the system manager's systems
 				m_systemManager->OnEntitySignatureChanged( *entity );
 			}
 
+			return pool->Find( entityId );
+		}
+
+		/*
+		*	Gives the entity the passed value of component type <T>, adding the component or overwriting the one the entity already has
+		*	An overwritten component keeps its bookkeeping, the field indices and the world checksum are told about the change
+		*	@param	<T>:		The type of component to set
+		*	@param	EntityId:	The entity id of the entity to set the component on
+		*	@param	Value:		The new value of the component
+		*	@return	T*:			The component of the entity, returns nullptr if the component could not be added
+		*/
+		template<typename T>
+		T* SetComponent( EntityId entityId, T&& value )
+		{
+			T* component = FindComponent<T>( entityId );
+			if( component == nullptr )
+			{
+				return AddComponent<T>( entityId, std::move( value ) );
+			}
+
+			Overwrite( *component, std::move( value ), std::is_base_of<Component, T>() );
+			NotifyComponentChanged<T>( entityId );
+
 			return component;
 		}
 
+		/*
+		*	Starts a batch of added components, the systems only learn about the entities receiving components once the batch ends
+		*	Components must not be removed, nor entities destroyed, while a batch is open. Batches can be nested
+		*/
+		inline void BeginBatch() { ++m_batchDepth; }
+
+		/*
+		*	Ends the batch, the systems are updated once for every entity that received components during the batch
+		*/
+		void EndBatch();
+
 		/*
 		*	@brief	Finds the component of the passed class type on the passed entity
 		*	@param	<T>		The type of component to look for
@@ -117,121 +188,374 @@ namespace Nebula
 		*	@return	T*		Returns the component if found, returning nullptr, if otherwise
 		*/
 		template<typename T>
-		T* FindComponent( EntityId entityId )
+		T* FindComponent( EntityId entityId ) const
 		{
-			// Complile-time check to see if class T can be converted to class B, 
-				// valid for derivation check of class T from class B
-			CanConvert_From<T, Component>();
+			static_assert( IsComponent<T>::value, "Components must derive from Component or be trivially copyable" );
 
-			Entity* entity = m_entityManager->m_entities[entityId];
+			ComponentPool<T>* pool = FindPool<T>();
+			return pool != nullptr ? pool->Find( entityId ) : nullptr;
+		}
+
+		/*
+		*	Removes the passed component type from the entity with the passed entity id
+		*	@param	<T>:		The type of Component to remove
+		*	@param	EntityId:	The entity id of the entity to remove the component from
+		*/
+		template<typename T>
+		void RemoveComponent( EntityId entityId )
+		{
+			static_assert( IsComponent<T>::value, "Components must derive from Component or be trivially copyable" );
+
+			Entity* entity = GetEntity( entityId );
 			if( entity == nullptr )	// Entity does not exist
 			{
-				return nullptr;
+				return;
 			}
 
-			// Loop through the components of the same type, the id of the component type is used as the key to a vector of components 
-			Component* component = nullptr;
+			ComponentPool<T>* pool = FindPool<T>();
+			T* component = pool != nullptr ? pool->Find( entityId ) : nullptr;
+			if( component == nullptr )	// Component does not exist on this entity
+			{
+				return;
+			}
 
-			const size_t size = m_componentMap[T::ID].size();
-			for( size_t i = 0; i < size; i++ )	// Iterator through vector of components from the same type
+			DetachComponent( *entity, component, std::is_base_of<Component, T>() );
+			--this->m_componentCounter;
+
+			entity->m_signature.reset( GetSignatureIndex<T>() );
+
+			if( pool->GetGroup() != nullptr )
 			{
-				component = m_componentMap[T::ID][i];
+				LeaveGroup( *pool->GetGroup(), entityId );
+			}
 
-				if( component == nullptr )
-				{
-					continue;
-				}
+			UnindexComponent( *pool, entityId );
 
-				if( component->m_ownerId == entityId )		// When we find the first component with the same owner, we can return it
-				{
+			RemoveFromPool( pool, entityId );
 
-					return dynamic_cast<T*>( component );
-				}
+			if( m_systemManager )
+			{
+				// Update systems, now that we have removed a component from this entity
+				m_systemManager->OnEntitySignatureChanged( *entity );
 			}
+		}
 
-			return nullptr;
+		/*
+		*	Adds the passed tag type to the entity with the passed EntityId, tags are only stored as a bit inside of the entity's signature
+		*	@param	<T>:		The type of Tag to add, must be an empty type derived from Tag
+		*	@param	EntityId:	The entity id of the entity to add the tag to
+		*	@return	bool:		Returns true, if the tag was added. Returns false, if the entity does not exist or already has the tag
+		*/
+		template<typename T>
+		bool AddTag( EntityId entityId )
+		{
+			CanConvert_From<T, Tag>();
+			static_assert( std::is_empty<T>::value, "Tags cannot contain any data" );
+			static_assert( !std::is_same<T, Hibernating>::value, "Entities start hibernating through Hibernate" );
+
+			const size_t signatureIndex = GetSignatureIndex<T>();
+			if( signatureIndex >= MAX_COMPONENT_TYPES )	// This tag type cannot be represented in an entity's signature
+			{
+				return false;
+			}
+
+			Entity* entity = GetEntity( entityId );
+			if( entity == nullptr || entity->m_signature.test( signatureIndex ) || IsHibernating( *entity ) )	// Entity does not exist, is already tagged or is hibernating
+			{
+				return false;
+			}
+
+			entity->m_signature.set( signatureIndex );
+
+			// Tags such as Prefab decide group and index membership too
+			RefreshGroups( *entity );
+			RefreshIndices( *entity );
+
+			if( m_systemManager )
+			{
+				m_systemManager->OnEntitySignatureChanged( *entity );
+			}
+
+			return true;
 		}
 
 		/*
-		*	Removes the passed component type from the entity with the passed entity id
-		*	@param	<T>:		The type of Component to remove, if multiple components of the same type exist, the first component of type <T> found will be removed
-		*	@param	EntityId:	The entity id of the entity to remove the component from
+		*	Removes the passed tag type from the entity with the passed EntityId
+		*	@param	<T>:		The type of Tag to remove
+		*	@param	EntityId:	The entity id of the entity to remove the tag from
 		*/
 		template<typename T>
-		void RemoveComponent( EntityId entityId )
+		void RemoveTag( EntityId entityId )
+		{
+			CanConvert_From<T, Tag>();
+
+			Entity* entity = GetEntity( entityId );
+			if( entity == nullptr || !HasTag<T>( *entity ) || IsHibernating( *entity ) )	// Entity does not exist, is not tagged or is hibernating
+			{
+				return;
+			}
+
+			entity->m_signature.reset( GetSignatureIndex<T>() );
+
+			RefreshGroups( *entity );
+			RefreshIndices( *entity );
+
+			if( m_systemManager )
+			{
+				m_systemManager->OnEntitySignatureChanged( *entity );
+			}
+		}
+
+		/*
+		*	@brief	Checks if the entity with the passed EntityId has the passed tag type
+		*	@param	<T>		The type of Tag to look for
+		*	@param	EntityId	The entityId of the entity to check
+		*	@return	bool	Returns true, if the entity exists and has the tag. Returns false, if otherwise
+		*/
+		template<typename T>
+		bool HasTag( EntityId entityId )
 		{
-			// Complile-time check to see if class T can be converted to class B, 
-				// valid for derivation check of class T from class B
-			CanConvert_From<T, Component>();
+			CanConvert_From<T, Tag>();
 
-			Entity* entity = m_entityManager->m_entities[entityId];
+			Entity* entity = GetEntity( entityId );
 			if( entity == nullptr )	// Entity does not exist
+			{
+				return false;
+			}
+
+			return HasTag<T>( *entity );
+		}
+
+
+		/*
+		*	Files the entity under the current values of its component of type <T>, in every field index of that type
+		*	Call after changing a component in place, the field indices and the world checksum do not see the change otherwise
+		*	@param	<T>:		The type of the changed component
+		*	@param	EntityId:	The owner of the changed component
+		*/
+		template<typename T>
+		void NotifyComponentChanged( EntityId entityId )
+		{
+			static_assert( IsComponent<T>::value, "Components must derive from Component or be trivially copyable" );
+
+			ComponentPool<T>* pool = FindPool<T>();
+			if( pool == nullptr )
 			{
 				return;
 			}
 
-			// Loop through the components of the same type, the id of the component type is used as the key to a vector of components 
-			Component* component = nullptr;
+			pool->MarkChanged( entityId );
 
-			const size_t size = m_componentMap[T::ID].size();
-			for( size_t i = 0; i < size; i++ )	// Iterator through vector of components from the same type
+			Entity* entity = GetEntity( entityId );
+			if( entity != nullptr && !pool->GetFieldIndices().empty() && entity->m_signature.test( GetSignatureIndex<T>() ) )
 			{
-				component = m_componentMap[T::ID][i];
+				IndexComponent( *pool, *entity );
+			}
+		}
 
-				if( component == nullptr )
-				{
-					continue;
-				}
+		/*
+		*	Flags every component of type <T> as changed for the world checksum, i.e. after a system wrote to all of them through ForEach
+		*/
+		template<typename T>
+		void MarkComponentsChanged()
+		{
+			ComponentPool<T>* pool = FindPool<T>();
+			if( pool != nullptr )
+			{
+				pool->MarkAllChanged();
+			}
+		}
 
-				if( component->m_ownerId == entityId )		// When we find the first component with the same owner, we will remove it
-				{
+		/*
+		*	The checksum of every component along with its owner, for peers in lockstep to detect when their worlds diverge
+		*	Each pool keeps a CRC32 per chunk, only the chunks changed since the previous call are hashed again
+		*	The pools are combined in the order of their type key, see ComponentReflection::GetTypeKey, so the order component types were first used in does not matter
+		*	Components added, removed or moved by the world are seen on their own, ForEachChunk flags the chunks it hands out
+		*	Changes made in place through other pointers must be reported with NotifyComponentChanged or MarkComponentsChanged
+		*	Tags, and the components of hibernating entities, are not covered
+		*	@return	uint32_t:	The checksum, equal on two worlds that hold the same components in the same order
+		*/
+		uint32_t GetChecksum();
 
-					// Remove the component, from the ComponentMap Vector, replacing the component to be removed with last component in the vector
-					m_componentMap[T::ID][i] = m_componentMap[T::ID][size - 1];
-					m_componentMap[T::ID].pop_back();
+		/*
+		*	Brings the checksums of all pools up to date, the first step to locate a divergence once the world checksums of two peers differ
+		*	@param	Checksums:	Receives the type key and checksum of each component type holding components, in increasing order of type key
+		*/
+		void GetPoolChecksums( std::vector< std::pair<uint64_t, uint32_t> >& checksums );
 
-					ComponentId componentId = component->m_componentId;
+		/*
+		*	@return	vector<uint32_t>*:	The checksum of each chunk of the component type with the passed type key, as of the last GetChecksum or GetPoolChecksums
+		*								Returns nullptr, if no component of this type was ever added
+		*/
+		const std::vector<uint32_t>* GetChunkChecksums( uint64_t typeKey ) const;
 
-					// Save this for the swapping later
-					uint64_t lastComponentId = --m_entityManager->m_entities[entityId]->m_componentCounter;
+		/*
+		*	@return	ComponentDescriptor*:	The layout of the component type with the passed signature index, i.e. for serializers handling pools of any type
+		*									Returns nullptr, if no component of this type was ever added
+		*/
+		const ComponentDescriptor* FindDescriptor( size_t signatureIndex ) const;
 
-					// Assign the component index of the component we are about to delete to the last component on this entity
-					m_entityManager->m_entities[entityId]->m_components[componentId] = m_entityManager->m_entities[entityId]->m_components[lastComponentId];
+		/*
+		*	Compares the chunk checksums of a component type with those of a peer, once their pool checksums differ
+		*	@param	TypeKey:			The component type, as listed by GetPoolChecksums
+		*	@param	RemoteChecksums:	The chunk checksums of the peer, from its GetChunkChecksums
+		*	@param	Entities:			Receives the owners of the components of the first diverging chunk
+		*	@return	size_t:				The index of the first diverging chunk, INVALID_CHUNK if every chunk matches
+		*/
+		size_t FindDivergingChunk( uint64_t typeKey, const std::vector<uint32_t>& remoteChecksums, std::vector<EntityId>& entities ) const;
 
-					// If this component is a valid component, then we give it a new component id
-					if( m_entityManager->m_entities[entityId]->m_components[componentId] != nullptr )
-					{
-						m_entityManager->m_entities[entityId]->m_components[componentId]->m_componentId = componentId;
-					}
+		// Returned by FindDivergingChunk when the chunks of both peers match
+		static constexpr size_t INVALID_CHUNK = static_cast<size_t>( -1 );
 
-					// Making sure we clean up what we left behind
-					m_entityManager->m_entities[entityId]->m_components[lastComponentId] = nullptr;
+		/*
+		*	Creates an index finding entities by the value of the passed field of their component of type <T>, in constant time
+		*	The index covers the existing components right away, and is kept up to date as components are added and removed
+		*	Prefabs and destroyed entities are never indexed
+		*	@param	Field:		The indexed member of <T>, i.e. &PlayerComponent::m_team
+		*	@return	HashIndex*:	The created index, owned by this component manager. Returns nullptr, if the type cannot be represented in a signature
+		*/
+		template<typename T, typename Key>
+		HashIndex<T, Key>* CreateHashIndex( Key T::* field )
+		{
+			static_assert( IsComponent<T>::value, "Components must derive from Component or be trivially copyable" );
 
-					// Now we will perform the similar operation for the Component Manager's Array of Components
-					// Just using local function variables that already exist
-					componentId = component->m_componentManagerId;
-					lastComponentId = --this->m_componentCounter;
+			ComponentPool<T>* pool = GetPool<T>();
+			if( pool == nullptr )
+			{
+				return nullptr;
+			}
 
-					// Assign the last component in the array to the removed component's index
-					m_components[componentId] = m_components[lastComponentId];
-					m_components[lastComponentId] = nullptr;
+			HashIndex<T, Key>* index = new HashIndex<T, Key>( field );
+			AddFieldIndex( *pool, GetSignatureIndex<T>(), index );
+			return index;
+		}
 
-					if( m_components[componentId] != nullptr )
-					{
-						m_components[componentId]->m_componentManagerId = componentId;
-					}
+		/*
+		*	Creates an index keeping entities sorted by the value of the passed field of their component of type <T>
+		*	Values and ranges of values are found in logarithmic time, otherwise the index behaves like CreateHashIndex
+		*	@param	Field:			The indexed member of <T>, i.e. &PositionComponent::m_x
+		*	@return	OrderedIndex*:	The created index, owned by this component manager. Returns nullptr, if the type cannot be represented in a signature
+		*/
+		template<typename T, typename Key>
+		OrderedIndex<T, Key>* CreateOrderedIndex( Key T::* field )
+		{
+			static_assert( IsComponent<T>::value, "Components must derive from Component or be trivially copyable" );
 
-					// Update systems, now that we have removed a component from this entity
-					m_systemManager->OnEntitySignatureChanged( *entity );
+			ComponentPool<T>* pool = GetPool<T>();
+			if( pool == nullptr )
+			{
+				return nullptr;
+			}
 
-					MarkComponentForCleanUp( component );
+			OrderedIndex<T, Key>* index = new OrderedIndex<T, Key>( field );
+			AddFieldIndex( *pool, GetSignatureIndex<T>(), index );
+			return index;
+		}
 
-					break;
-				}
+
+		/*
+		*	Makes the entity share the passed value with every other entity holding an equal value of type <T>
+		*	Each distinct value is stored once, the entity only holds a Shared<T> component with the index of the value
+		*	Calling it again moves the entity over to the new value, a value is released once no entity shares it anymore
+		*	@param	<T>:		The shared component type, must be trivially copyable
+		*	@param	EntityId:	The entity sharing the value
+		*	@param	Value:		The shared value
+		*	@return	bool:		Returns true, if the entity shares the value
+		*/
+		template<typename T>
+		bool SetSharedComponent( EntityId entityId, const T& value )
+		{
+			if( GetEntity( entityId ) == nullptr )	// Entity does not exist
+			{
+				return false;
 			}
 
+			SharedComponentStore<T>* store = GetSharedStore<T>();
+			if( store == nullptr )
+			{
+				return false;
+			}
+
+			const uint32_t valueIndex = store->Acquire( value );
+
+			if( FindComponent< Shared<T> >( entityId ) != nullptr )
+			{
+				store->Move( entityId, valueIndex );
+				return true;
+			}
+
+			if( AddComponent< Shared<T> >( entityId, valueIndex ) == nullptr )
+			{
+				store->ReleaseIfUnused( valueIndex );
+				return false;
+			}
+
+			return true;
+		}
+
+		/*
+		*	@return	T*:		The value shared by the entity, nullptr if the entity shares no value of type <T>
+		*					The value stays valid until a new value of type <T> is stored
+		*/
+		template<typename T>
+		const T* FindSharedComponent( EntityId entityId ) const
+		{
+			const SharedComponentStore<T>* store = FindSharedStore<T>();
+			return store != nullptr ? store->Find( entityId ) : nullptr;
 		}
 
+		/*
+		*	Stops the entity from sharing a value of type <T>
+		*/
+		template<typename T>
+		void RemoveSharedComponent( EntityId entityId )
+		{
+			RemoveComponent< Shared<T> >( entityId );
+		}
+
+		/*
+		*	@return	SharedComponentStore<T>*:	The values of the shared component type <T>, nullptr if no value of this type was ever shared
+		*/
+		template<typename T>
+		const SharedComponentStore<T>* FindSharedStore() const
+		{
+			const size_t index = GetSignatureIndex< Shared<T> >();
+			return index < m_sharedStores.size() ? static_cast< const SharedComponentStore<T>* >( m_sharedStores[index] ) : nullptr;
+		}
+
+		/*
+		*	Gives each of the passed entities a copy of every component and tag of the prefab, except for the Prefab tag itself
+		*	Components are copied pool by pool, byte by byte when the component type is trivially copyable
+		*	The systems are updated once all entities have their components, one system at a time
+		*	@param	PrefabId:		The entity to copy from, usually tagged with Prefab
+		*	@param	Entities:		The entities to copy to, entities that already have components are skipped, as are repeated entities
+		*	@return	bool:			Returns false and copies nothing, if the prefab does not exist, is hibernating, has a component that cannot be copied, or the copies would exceed the component limit
+		*/
+		bool Instantiate( EntityId prefabId, const std::vector<EntityId>& entities );
+
+		/*
+		*	Moves the components of the passed entities out of their pools into cold storage, the entities leave their systems in one batch
+		*	Trivially copyable components are kept as bytes, optionally compressed, other components are moved into a cold pool of their type
+		*	Hibernating entities keep their EntityId, but have no components or tags until they wake, their signature only holds Hibernating
+		*	@param	Entities:	The entities to hibernate, entities that do not exist, already hibernate or are tagged with Prefab are skipped
+		*	@param	bCompress:	Compresses the bytes of each entity with run-length encoding
+		*	@return	size_t:		The number of entities that started hibernating
+		*/
+		size_t Hibernate( const std::vector<EntityId>& entities, bool bCompress = false );
+
+		/*
+		*	Moves the components of the passed hibernating entities back into their pools, the systems are updated once for the whole batch
+		*	@param	Entities:	The entities to wake, entities that are not hibernating are skipped
+		*	@return	size_t:		The number of entities woken up
+		*/
+		size_t Wake( const std::vector<EntityId>& entities );
+
+		// Returns true, if the entity with the passed EntityId is hibernating
+		bool IsHibernating( EntityId entityId ) const;
+
+		// The number of hibernating entities, and the bytes held for them by the cold store
+		inline size_t GetHibernatingCount() const { return m_coldStore.GetSize(); }
+		inline size_t GetHibernatingByteCount() const { return m_coldStore.GetByteCount(); }
 
 		/*
 		*	Removes all components from the entity with the passed entity id
@@ -239,33 +563,355 @@ namespace Nebula
 		*/
 		void RemoveAllComponents( EntityId entityId );
 
+		/*
+		*	Detaches all components and tags from the entity with the passed entity id, the entity leaves all of its systems
+		*	The components themselves are destroyed later, by CleanUpComponents
+		*	@param	EntityId:		The entity id of the entity that is being destroyed
+		*/
+		void MarkComponentsForCleanUp( EntityId entityId );
+
+		/*
+		*	Destroys the components left behind by the passed entity, after MarkComponentsForCleanUp
+		*	@param	EntityId:		The entity id of the destroyed entity
+		*/
+		void CleanUpComponents( EntityId entityId );
+
+		/*
+		*	Releases the storage that is no longer needed by the component pools
+		*/
+		void ReleaseUnusedMemory();
+
+		/*
+		*	Starts publishing the state of the passed component type at the end of every world update, see ComponentSnapshot
+		*	Must be called before any other thread reads snapshots
+		*	@return	ComponentSnapshot<T>*:	The snapshot of the component type, returns nullptr if the type cannot be represented in a signature
+		*/
+		template<typename T>
+		ComponentSnapshot<T>* EnableSnapshots()
+		{
+			ComponentPool<T>* pool = GetPool<T>();
+			if( pool == nullptr )
+			{
+				return nullptr;
+			}
+
+			const size_t index = GetSignatureIndex<T>();
+			if( index >= m_snapshots.size() )
+			{
+				m_snapshots.resize( index + 1, nullptr );
+			}
+
+			if( m_snapshots[index] == nullptr )
+			{
+				m_snapshots[index] = new ComponentSnapshot<T>( pool );
+			}
+
+			return static_cast< ComponentSnapshot<T>* >( m_snapshots[index] );
+		}
+
+		/*
+		*	@return	ComponentSnapshot<T>*:	The snapshot of the passed component type, nullptr if snapshots are not enabled for the type
+		*/
+		template<typename T>
+		const ComponentSnapshot<T>* FindSnapshot() const
+		{
+			const size_t index = GetSignatureIndex<T>();
+			return index < m_snapshots.size() ? static_cast< const ComponentSnapshot<T>* >( m_snapshots[index] ) : nullptr;
+		}
+
+		/*
+		*	Publishes the state of every component type with snapshots enabled
+		*/
+		void PublishSnapshots();
+
+		/*
+		*	Replaces the allocator providing the memory of the component pools, only possible before the first component is added
+		*	@param	Allocator:	The new allocator, the component manager takes ownership of it
+		*	@return	bool:		Returns true, if the allocator was replaced. Returns false and leaves the allocator to the caller, if a pool already exists
+		*/
+		bool SetChunkAllocator( ChunkAllocator* allocator );
+
+		// Disabled entities are skipped when systems iterate their components, see EntityManager::SetEntityEnabled
+		inline bool IsEntityEnabled( EntityId entityId ) const { return m_entityManager->IsEntityEnabled( entityId ); }
+
+		inline bool HasDisabledEntities() const { return m_entityManager->HasDisabledEntities(); }
+
+		/*
+		*	@return	ComponentPool<T>*:	The storage of the passed component type, created if it does not exist yet
+		*/
+		template<typename T>
+		ComponentPool<T>* GetPool()
+		{
+			const size_t index = GetSignatureIndex<T>();
+			if( index >= MAX_COMPONENT_TYPES )
+			{
+				return nullptr;
+			}
+
+			if( index >= m_pools.size() )
+			{
+				m_pools.resize( index + 1, nullptr );
+			}
+
+			if( m_pools[index] == nullptr )
+			{
+				m_pools[index] = new ComponentPool<T>( m_chunkAllocator );
+				m_pools[index]->m_signatureIndex = index;
+				m_pools[index]->m_typeKey = ComponentReflection<T>::GetTypeKey();
+				AddPoolByTypeKey( m_pools[index] );
+			}
+
+			return static_cast< ComponentPool<T>* >( m_pools[index] );
+		}
+
+		/*
+		*	@return	ComponentPool<T>*:	The storage of the passed component type, nullptr if no component of this type was ever added
+		*/
+		template<typename T>
+		ComponentPool<T>* FindPool() const
+		{
+			const size_t index = GetSignatureIndex<T>();
+			return index < m_pools.size() ? static_cast< ComponentPool<T>* >( m_pools[index] ) : nullptr;
+		}
+
+		/*
+		*	Creates an owning group for the passed component types, see ComponentGroup
+		*	Entities that already have all of the component types are moved into the group right away
+		*	@param	<Components>:	The component types owned by the group
+		*	@return	ComponentGroup*:	The created group, or the existing group owning exactly these types
+		*							Returns nullptr, if any of the types is already owned by another group
+		*/
+		template<typename ... Components>
+		ComponentGroup* CreateGroup()
+		{
+			Signature mask;
+			SetSignatureBits<Components ...>( mask );
+
+			return CreateGroup( mask, { GetPool<Components>() ... } );
+		}
+
+		/*
+		*	Moves the components of the passed entities to the front of the pools of the passed component types, in the same order
+		*	Afterwards, index i of each of these pools holds the component of entities[i], making the pools iterable side by side
+		*	A pool packed for an owner is claimed by it, packing it for a different set of entities would undo the other's order every time
+		*	Nothing is moved if any of the pools is owned by a group, or is claimed by another owner
+		*	@param	<Components>:	The component types to pack, every passed entity must have all of them
+		*	@param	Entities:		The entities in the order their components should be stored
+		*	@param	Owner:			Claims the pools until ReleasePackedPools is called with it, nullptr packs unclaimed pools without claiming them
+		*	@return	bool:			True if the pools were packed
+		*/
+		template<typename ... Components>
+		bool PackComponents( const std::vector<EntityId>& entities, const void* owner = nullptr )
+		{
+			IComponentPool* pools[] = { GetPool<Components>() ... };
+
+			for( IComponentPool* pool : pools )
+			{
+				if( pool == nullptr || pool->m_group != nullptr || ( pool->m_packOwner != nullptr && pool->m_packOwner != owner ) )
+				{
+					return false;
+				}
+			}
+
+			for( IComponentPool* pool : pools )
+			{
+				PackPool( pool, entities );
+				pool->m_packOwner = owner;
+			}
+			return true;
+		}
+
+		/*
+		*	Lets go of every pool claimed by the passed owner, see PackComponents
+		*/
+		void ReleasePackedPools( const void* owner );
+
+		/*
+		*	Appends every live entity to the passed entities, in increasing order of EntityId
+		*/
+		void GetLiveEntities( std::vector<Entity*>& entities ) const;
+
 
 	private:
 
+		// Returns the store of the shared component type <T>, created if it does not exist yet
+		template<typename T>
+		SharedComponentStore<T>* GetSharedStore()
+		{
+			ComponentPool< Shared<T> >* pool = GetPool< Shared<T> >();
+			if( pool == nullptr )
+			{
+				return nullptr;
+			}
+
+			const size_t index = GetSignatureIndex< Shared<T> >();
+			if( index >= m_sharedStores.size() )
+			{
+				m_sharedStores.resize( index + 1, nullptr );
+			}
+
+			if( m_sharedStores[index] == nullptr )
+			{
+				m_sharedStores[index] = new SharedComponentStore<T>( pool );
+				AddFieldIndex( *pool, index, m_sharedStores[index] );
+			}
+
+			return static_cast< SharedComponentStore<T>* >( m_sharedStores[index] );
+		}
+
+		// Returns the live entity with the passed id, nullptr if it does not exist
+		Entity* GetEntity( EntityId entityId ) const;
+
+		// Inserts a new pool into m_poolsByTypeKey, keeping it sorted
+		void AddPoolByTypeKey( IComponentPool* pool );
+
+		// Returns the pool of the component type with the passed type key, nullptr if no component of this type was ever added
+		IComponentPool* FindPoolByTypeKey( uint64_t typeKey ) const;
+
+		// Fills in the bookkeeping of a component that was just added to the passed entity
+		inline void AttachComponent( Entity& entity, Component* component, uint32_t index, std::true_type )
+		{
+			component->m_ownerId = entity.m_entityId;
+			component->m_componentId = static_cast<ComponentId>( entity.m_componentCounter );
+			++entity.m_componentCounter;
+			entity.m_components.push_back( component );
+
+			component->m_componentManagerId = index;
+		}
+
+		// Plain components are only known to their pool
+		inline void AttachComponent( Entity&, const void*, uint32_t, std::false_type )
+		{}
+
+		// The bookkeeping of the overwritten component belongs to its entity and pool, it survives the assignment
+		template<typename T>
+		static void Overwrite( T& component, T&& value, std::true_type )
+		{
+			const Component bookkeeping( static_cast<const Component&>( component ) );
+			component = std::move( value );
+			static_cast<Component&>( component ) = bookkeeping;
+		}
+
+		template<typename T>
+		static void Overwrite( T& component, T&& value, std::false_type )
+		{
+			component = std::move( value );
+		}
+
+		// Removes a component that is about to be destroyed from the passed entity's components
+		inline void DetachComponent( Entity& entity, Component* component, std::true_type )
+		{
+			ComponentId componentId = component->m_componentId;
+
+			// Save this for the swapping later
+			uint64_t lastComponentId = --entity.m_componentCounter;
+
+			// Assign the component index of the component we are about to delete to the last component on this entity
+			entity.m_components[componentId] = entity.m_components[lastComponentId];
+
+			// If this component is a valid component, then we give it a new component id
+			if( entity.m_components[componentId] != nullptr )
+			{
+				entity.m_components[componentId]->m_componentId = componentId;
+			}
+
+			// Making sure we clean up what we left behind
+			entity.m_components.pop_back();
+		}
+
+		inline void DetachComponent( Entity&, const void*, std::false_type )
+		{}
+
 		/*
-		*	Removes all components from this component manager
+		*	@return	size_t:		The number of components, of any kind, described by the passed signature
 		*/
-		void RemoveAllComponentsOnManager();
+		size_t CountComponents( const Signature& signature ) const;
+
+		inline bool IsHibernating( const Entity& entity ) const
+		{
+			return entity.m_signature.test( GetSignatureIndex<Hibernating>() );
+		}
 
+		/*
+		*	Destroys the cold components of the passed hibernating entity, leaving it without components or tags
+		*/
+		void DiscardHibernatingComponents( Entity& entity );
 
-		// Utility function for the ComponentManager to remove components given their component type
 		/*
-		*	Utility function for removing the passed component type from the entity with the passed entity id
-		*	@param	ComponentType:		The type of Component to remove, if multiple components of the same type exist, the first component of the ComponentType found will be removed
-		*	@param	EntityId:	The entity id of the entity to remove the component from
+		*	Tells the field indices of the component types of the passed signature that the entity hibernates, or that it stopped hibernating
+		*/
+		void NotifyHibernation( EntityId entityId, const Signature& signature, bool bHibernating );
+
+		// Checks the entity's signature for the passed tag type
+		template<typename T>
+		bool HasTag( const Entity& entity ) const
+		{
+			const size_t signatureIndex = GetSignatureIndex<T>();
+			return signatureIndex < MAX_COMPONENT_TYPES && entity.m_signature.test( signatureIndex );
+		}
+
+		/*
+		*	Destroys the component of the passed entity inside of the passed pool, and updates the component moved into its place
+		*/
+		void RemoveFromPool( IComponentPool* pool, EntityId entityId );
+
+		/*
+		*	Updates the bookkeeping of the component at the passed index of the pool, and the systems holding it, after it has changed places
+		*/
+		void OnComponentRelocated( IComponentPool* pool, uint32_t index );
+
+		/*
+		*	Packs the components of the passed entities at the front of the pool
+		*/
+		void PackPool( IComponentPool* pool, const std::vector<EntityId>& entities );
+
+		/*
+		*	Exchanges the places of two components of the pool
+		*/
+		void SwapComponents( IComponentPool* pool, uint32_t first, uint32_t second );
+
+		// Non-template implementation of CreateGroup
+		ComponentGroup* CreateGroup( const Signature& mask, const std::vector<IComponentPool*>& pools );
+
+		/*
+		*	Moves the passed entity into the group, if it has all of the group's component types and is not in the group already
+		*/
+		void JoinGroup( ComponentGroup& group, const Entity& entity );
+
+		/*
+		*	Moves the passed entity out of the group, if it is in the group
+		*/
+		void LeaveGroup( ComponentGroup& group, EntityId entityId );
+
+		/*
+		*	Moves the passed entity out of every group it is in
+		*/
+		void LeaveAllGroups( EntityId entityId );
+
+		/*
+		*	Moves the passed entity into or out of every group, to match its signature
+		*/
+		void RefreshGroups( const Entity& entity );
+
+		/*
+		*	Registers the index with the pool, and indexes the components the pool already holds
+		*/
+		void AddFieldIndex( IComponentPool& pool, size_t signatureIndex, IFieldIndex* index );
+
+		/*
+		*	Files the passed entity's component of the pool in every field index of the pool, prefabs are left out of indices that do not take them
 		*/
-		void RemoveComponent( const Entity& entity, const uint64_t& componentType );
+		void IndexComponent( IComponentPool& pool, const Entity& entity );
 
 		/*
-		*	Marks a component for cleanup and moves it to the clean up vector of components
-		*	@param	Component:		The Component that will be marked to cleanup
+		*	Removes the passed entity from every field index of the pool
 		*/
-		void MarkComponentForCleanUp( Component* component );
+		void UnindexComponent( IComponentPool& pool, EntityId entityId );
 
 		/*
-		*	Cleans up all components marked for clean up
+		*	Adds the passed entity to or removes it from every field index, to match its signature
 		*/
-		void CleanUpComponents();
+		void RefreshIndices( const Entity& entity );
 
 	};
 
@@ -0,0 +1,653 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_COMPONENTPOOL_H
+#define NEBULA_COMPONENTPOOL_H
+
+#include "Constants.h"
+#include "Component.h"
+#include "ChunkAllocator.h"
+#include "ComponentChecksum.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Nebula
+{
+	class IFieldIndex;
+
+	/*
+	*	Type-erased storage for all the components of a single type
+	*	Components are kept densely packed, in chunks of aligned memory, and are looked up by EntityId in constant time
+	*	Removing a component moves the last component of the pool into its place, components are therefore not address-stable
+	*/
+	class IComponentPool
+	{
+	public:
+		// Sentinel for an entity that has no component in this pool
+		static constexpr uint32_t INVALID_INDEX = static_cast<uint32_t>( -1 );
+
+		IComponentPool( size_t elementSize, ChunkAllocator* allocator ) :
+			m_elementSize( elementSize ),
+			m_signatureIndex( MAX_COMPONENT_TYPES ),
+			m_typeKey( 0 ),
+			m_size( 0 ),
+			m_layoutVersion( 0 ),
+			m_group( nullptr ),
+			m_packOwner( nullptr ),
+			m_allocator( allocator ),
+			m_checksum( 0 )
+		{}
+
+		virtual ~IComponentPool()
+		{
+			for( auto* chunk : m_chunks )
+			{
+				m_allocator->Free( chunk, GetChunkSize() );
+			}
+			m_chunks.clear();
+		}
+
+		inline size_t GetSize() const { return m_size; }
+
+		inline size_t GetChunkCapacity() const { return COMPONENT_CHUNK_CAPACITY; }
+
+		inline size_t GetChunkCount() const { return m_chunks.size(); }
+
+		// Size in bytes of a single chunk
+		inline size_t GetChunkSize() const { return m_elementSize * COMPONENT_CHUNK_CAPACITY; }
+
+		// Incremented every time components of this pool change places
+		inline uint64_t GetLayoutVersion() const { return m_layoutVersion; }
+
+		// The owning group of this pool, nullptr if the pool is not owned
+		inline class ComponentGroup* GetGroup() const { return m_group; }
+
+		// The field indices kept up to date with the components of this pool
+		inline const std::vector<IFieldIndex*>& GetFieldIndices() const { return m_fieldIndices; }
+
+		inline bool Has( EntityId entityId ) const { return GetIndex( entityId ) != INVALID_INDEX; }
+
+		inline uint32_t GetIndex( EntityId entityId ) const
+		{
+			return entityId < m_sparse.size() ? m_sparse[entityId] : INVALID_INDEX;
+		}
+
+		// The owning entity of each component, indexed by the component's index inside of this pool
+		inline const std::vector<EntityId>& GetEntities() const { return m_entities; }
+
+		// The index of each entity's component, indexed by EntityId, INVALID_INDEX for entities without a component
+		inline const std::vector<uint32_t>& GetSparse() const { return m_sparse; }
+
+		// The first component of the passed chunk, aligned to COMPONENT_CHUNK_ALIGNMENT
+		inline void* GetChunkData( size_t chunkIndex ) const { return m_chunks[chunkIndex]; }
+
+		/*
+		*	Releases the chunks that are no longer needed to hold the components of this pool, one empty chunk is kept to absorb churn
+		*/
+		void ReleaseUnusedChunks()
+		{
+			const size_t chunksToKeep = ( m_size + COMPONENT_CHUNK_CAPACITY - 1 ) / COMPONENT_CHUNK_CAPACITY + 1;
+			while( m_chunks.size() > chunksToKeep && m_chunkPins.back() == 0 )
+			{
+				m_allocator->Free( m_chunks.back(), GetChunkSize() );
+				m_chunks.pop_back();
+				m_chunkPins.pop_back();
+			}
+		}
+
+		/*
+		*	Keeps the passed chunk resident while it is in use, pins are counted and every pin must be matched by an UnpinChunk
+		*/
+		void PinChunk( size_t chunkIndex )
+		{
+			if( m_chunkPins[chunkIndex]++ == 0 )
+			{
+				m_allocator->Pin( m_chunks[chunkIndex], GetChunkSize() );
+			}
+		}
+
+		void UnpinChunk( size_t chunkIndex )
+		{
+			if( --m_chunkPins[chunkIndex] == 0 )
+			{
+				m_allocator->Unpin( m_chunks[chunkIndex], GetChunkSize() );
+			}
+		}
+
+		/*
+		*	Flags the chunk holding the component of the passed entity as changed, its checksum is computed again by the next GetChecksum
+		*	Adding, removing and moving components flags their chunks on its own, only changes made in place need to be flagged
+		*/
+		inline void MarkChanged( EntityId entityId )
+		{
+			const uint32_t index = GetIndex( entityId );
+			if( index != INVALID_INDEX )
+			{
+				MarkChunkChanged( index / COMPONENT_CHUNK_CAPACITY );
+			}
+		}
+
+		void MarkChunkChanged( size_t chunkIndex )
+		{
+			if( chunkIndex >= m_chunkChecksums.size() )
+			{
+				m_chunkChecksums.resize( chunkIndex + 1, 0 );
+				m_bChunksChanged.resize( chunkIndex + 1, false );
+			}
+
+			if( !m_bChunksChanged[chunkIndex] )
+			{
+				m_bChunksChanged[chunkIndex] = true;
+				m_changedChunks.push_back( static_cast<uint32_t>( chunkIndex ) );
+			}
+		}
+
+		// Flags every chunk holding components as changed
+		void MarkAllChanged()
+		{
+			const size_t chunkCount = ( m_size + COMPONENT_CHUNK_CAPACITY - 1 ) / COMPONENT_CHUNK_CAPACITY;
+			for( size_t chunk = 0; chunk < chunkCount; ++chunk )
+			{
+				MarkChunkChanged( chunk );
+			}
+		}
+
+		/*
+		*	The checksum of every component of this pool along with its owner, in the order they are stored
+		*	Only the chunks changed since the previous call are hashed again, the checksums of the chunks are combined with xor
+		*	@return	uint32_t:	The checksum, 0 for an empty pool
+		*/
+		uint32_t GetChecksum()
+		{
+			for( const uint32_t chunk : m_changedChunks )
+			{
+				const uint32_t checksum = chunk * COMPONENT_CHUNK_CAPACITY < m_size ? ComputeChunkChecksum( chunk ) : 0;
+				m_checksum ^= m_chunkChecksums[chunk] ^ checksum;
+				m_chunkChecksums[chunk] = checksum;
+				m_bChunksChanged[chunk] = false;
+			}
+			m_changedChunks.clear();
+
+			// Chunks past the last component hash to 0
+			const size_t chunkCount = ( m_size + COMPONENT_CHUNK_CAPACITY - 1 ) / COMPONENT_CHUNK_CAPACITY;
+			if( m_chunkChecksums.size() > chunkCount )
+			{
+				m_chunkChecksums.resize( chunkCount );
+				m_bChunksChanged.resize( chunkCount );
+			}
+
+			return m_checksum;
+		}
+
+		/*
+		*	The checksum of each chunk holding components, call GetChecksum first to bring them up to date
+		*	Chunk i holds the components of GetEntities()[i * COMPONENT_CHUNK_CAPACITY] onwards
+		*/
+		inline const std::vector<uint32_t>& GetChunkChecksums() const { return m_chunkChecksums; }
+
+		/*
+		*	Destroys the component owned by the passed entity, the last component of the pool is moved into its place
+		*	@param	EntityId:	The entity to remove the component from
+		*	@return	EntityId:	The entity whose component was moved to fill the gap, 0 if no component was moved
+		*/
+		virtual EntityId Remove( EntityId entityId ) = 0;
+
+		/*
+		*	Exchanges the places of the components at the two passed indices of this pool
+		*/
+		virtual void SwapElements( uint32_t first, uint32_t second ) = 0;
+
+		/*
+		*	The layout of the component type, for tools handling the components of any pool through GetChunkData, i.e. serializers and debuggers
+		*/
+		virtual const ComponentDescriptor& GetDescriptor() const = 0;
+
+		/*
+		*	@return	Component*:	The component at the passed index of this pool, nullptr if the component type does not derive from Component
+		*/
+		virtual Component* GetComponent( uint32_t index ) = 0;
+
+		/*
+		*	Copies the component at the passed index to the end of this pool, once for each of the passed entities
+		*	Entities that already have a component in this pool are skipped
+		*	@param	SourceIndex:	The index of the component to copy
+		*	@param	Entities:		The entities receiving a copy
+		*	@return	size_t:			The number of copies made, copying stops early if memory could not be allocated
+		*							Returns 0, if the component type cannot be copied
+		*/
+		virtual size_t Clone( uint32_t sourceIndex, const std::vector<EntityId>& entities ) = 0;
+
+		// Returns false if the components of this pool cannot be copied, Clone then copies nothing
+		virtual bool IsCopyable() const = 0;
+
+		/*
+		*	Moves the component at the passed index into cold storage, the moved-from component is left in this pool to be removed
+		*	Trivially copyable components are appended to the passed bytes, others are moved into a cold pool of the same type
+		*	@param	Index:		The index of the component inside of this pool
+		*	@param	Bytes:		The hibernated bytes of the component's entity
+		*/
+		virtual void Freeze( uint32_t index, std::vector<uint8_t>& bytes ) = 0;
+
+		/*
+		*	Moves the component of the passed entity back from cold storage, to the end of this pool
+		*	@param	EntityId:	The owner of the component
+		*	@param	Bytes:		A cursor inside of the entity's hibernated bytes, advanced past the bytes of this component
+		*	@return	bool:		Returns false, if the component could not be restored
+		*/
+		virtual bool Thaw( EntityId entityId, const uint8_t*& bytes ) = 0;
+
+		/*
+		*	Destroys the component of the passed entity held in cold storage, for entities destroyed while hibernating
+		*/
+		virtual void DiscardFrozen( EntityId entityId, const uint8_t*& bytes ) = 0;
+
+	protected:
+		/*
+		*	@return	uint32_t:	The CRC32 of the index, owners and components of the passed chunk, which holds at least one component
+		*/
+		virtual uint32_t ComputeChunkChecksum( size_t chunkIndex ) const = 0;
+
+		inline void* GetElement( size_t index ) const
+		{
+			return static_cast<uint8_t*>( m_chunks[index / COMPONENT_CHUNK_CAPACITY] ) + ( index % COMPONENT_CHUNK_CAPACITY ) * m_elementSize;
+		}
+
+		// Reserves the next index of this pool for the passed entity, allocating a new chunk when needed
+		// Returns nullptr if the memory for a new chunk could not be allocated
+		void* PushElement( EntityId entityId )
+		{
+			if( m_size == m_chunks.size() * COMPONENT_CHUNK_CAPACITY )
+			{
+				void* chunk = m_allocator->Allocate( GetChunkSize() );
+				if( chunk == nullptr )
+				{
+					return nullptr;
+				}
+				m_chunks.push_back( chunk );
+				m_chunkPins.push_back( 0 );
+			}
+
+			if( entityId >= m_sparse.size() )
+			{
+				m_sparse.resize( entityId + 1, INVALID_INDEX );
+			}
+
+			m_sparse[entityId] = static_cast<uint32_t>( m_size );
+			m_entities.push_back( entityId );
+			MarkChunkChanged( m_size / COMPONENT_CHUNK_CAPACITY );
+
+			return GetElement( m_size++ );
+		}
+
+		// Releases the last index of this pool, after its component has been destroyed or moved
+		void PopElement()
+		{
+			--m_size;
+			m_sparse[m_entities[m_size]] = INVALID_INDEX;
+			m_entities.pop_back();
+			MarkChunkChanged( m_size / COMPONENT_CHUNK_CAPACITY );
+		}
+
+		// Updates the bookkeeping of an element that was moved from one index to another
+		void SetElementIndex( uint32_t index, EntityId entityId )
+		{
+			m_entities[index] = entityId;
+			m_sparse[entityId] = index;
+			MarkChunkChanged( index / COMPONENT_CHUNK_CAPACITY );
+		}
+
+		// Size in bytes of a single component
+		size_t					m_elementSize;
+
+		// The bit of the component type inside of an entity's Signature, MAX_COMPONENT_TYPES for pools the ComponentManager does not look up by type
+		size_t					m_signatureIndex;
+
+		// The ComponentReflection<T>::GetTypeKey of the component type, the same on every peer, orders the pools of the world checksum
+		uint64_t				m_typeKey;
+
+		// The number of components in this pool
+		size_t					m_size;
+
+		uint64_t				m_layoutVersion;
+
+		// The group that decides the order of the first components of this pool
+		class ComponentGroup*	m_group;
+
+		// The owner this pool was packed for, see ComponentManager::PackComponents, nullptr if the pool is not claimed
+		const void*				m_packOwner;
+
+		// Owned by the ComponentManager
+		std::vector<IFieldIndex*>	m_fieldIndices;
+
+		// Provides the memory of the chunks
+		ChunkAllocator*			m_allocator;
+
+		// Aligned blocks of memory, each holding COMPONENT_CHUNK_CAPACITY components
+		std::vector<void*>		m_chunks;
+
+		// The number of pins held on each chunk
+		std::vector<uint32_t>	m_chunkPins;
+
+		// Owning entity of each component
+		std::vector<EntityId>	m_entities;
+
+		// Index of each entity's component, indexed by EntityId
+		std::vector<uint32_t>	m_sparse;
+
+		// The xor of the checksums of all chunks
+		uint32_t				m_checksum;
+
+		// The checksum of each chunk, as of the last GetChecksum
+		std::vector<uint32_t>	m_chunkChecksums;
+
+		// The chunks changed since the last GetChecksum, flagged per chunk and listed
+		std::vector<bool>		m_bChunksChanged;
+		std::vector<uint32_t>	m_changedChunks;
+
+	private:
+		friend class ComponentManager;
+
+		IComponentPool( const IComponentPool& ) = delete;
+		IComponentPool& operator=( const IComponentPool& ) = delete;
+		IComponentPool( IComponentPool&& ) = delete;
+		IComponentPool& operator=( IComponentPool&& ) = delete;
+	};
+
+	template<typename T>
+	class ComponentPool : public IComponentPool
+	{
+		static_assert( std::is_move_constructible<T>::value, "Components must be move constructible to be stored in a ComponentPool" );
+		static_assert( alignof( T ) <= COMPONENT_CHUNK_ALIGNMENT, "Component alignment cannot exceed COMPONENT_CHUNK_ALIGNMENT" );
+
+	public:
+		explicit ComponentPool( ChunkAllocator* allocator ) :
+			IComponentPool( sizeof( T ), allocator ),
+			m_coldPool( nullptr )
+		{}
+
+		~ComponentPool() override
+		{
+			for( size_t i = 0; i < m_size; ++i )
+			{
+				Get( i )->~T();
+			}
+
+			delete m_coldPool;
+			m_coldPool = nullptr;
+		}
+
+		/*
+		*	Constructs a component for the passed entity at the end of this pool
+		*	@return	T*:		The created component, returns nullptr if the entity already has a component in this pool or memory could not be allocated
+		*/
+		template<typename ... Args>
+		T* Emplace( EntityId entityId, Args&& ... args )
+		{
+			if( Has( entityId ) )
+			{
+				return nullptr;
+			}
+
+			void* element = PushElement( entityId );
+			if( element == nullptr )
+			{
+				return nullptr;
+			}
+
+			return Construct( element, std::is_constructible<T, Args ...>(), std::forward<Args>( args ) ... );
+		}
+
+		// Returns the component owned by the passed entity, nullptr if the entity has no component in this pool
+		inline T* Find( EntityId entityId ) const
+		{
+			const uint32_t index = GetIndex( entityId );
+			return index != INVALID_INDEX ? Get( index ) : nullptr;
+		}
+
+		inline T* Get( size_t index ) const
+		{
+			return static_cast<T*>( GetElement( index ) );
+		}
+
+		// The first component of the passed chunk, aligned to COMPONENT_CHUNK_ALIGNMENT
+		inline T* GetChunk( size_t chunkIndex ) const
+		{
+			return static_cast<T*>( GetChunkData( chunkIndex ) );
+		}
+
+		EntityId Remove( EntityId entityId ) override
+		{
+			const uint32_t index = GetIndex( entityId );
+			if( index == INVALID_INDEX )
+			{
+				return 0;
+			}
+
+			const uint32_t lastIndex = static_cast<uint32_t>( m_size - 1 );
+			const EntityId lastEntityId = m_entities[lastIndex];
+
+			Get( index )->~T();
+
+			if( index == lastIndex )
+			{
+				PopElement();
+				return 0;
+			}
+
+			// Move the last component into the gap left by the removed component
+			new( GetElement( index ) ) T( std::move( *Get( lastIndex ) ) );
+			Get( lastIndex )->~T();
+
+			PopElement();
+			SetElementIndex( index, lastEntityId );
+			m_sparse[entityId] = INVALID_INDEX;
+			++m_layoutVersion;
+
+			return lastEntityId;
+		}
+
+		void SwapElements( uint32_t first, uint32_t second ) override
+		{
+			if( first == second )
+			{
+				return;
+			}
+
+			T temp( std::move( *Get( first ) ) );
+			Get( first )->~T();
+			new( GetElement( first ) ) T( std::move( *Get( second ) ) );
+			Get( second )->~T();
+			new( GetElement( second ) ) T( std::move( temp ) );
+
+			const EntityId firstEntityId = m_entities[first];
+			SetElementIndex( first, m_entities[second] );
+			SetElementIndex( second, firstEntityId );
+			++m_layoutVersion;
+		}
+
+		const ComponentDescriptor& GetDescriptor() const override
+		{
+			return ComponentReflection<T>::GetDescriptor();
+		}
+
+		Component* GetComponent( uint32_t index ) override
+		{
+			return GetComponent( index, std::is_base_of<Component, T>() );
+		}
+
+		size_t Clone( uint32_t sourceIndex, const std::vector<EntityId>& entities ) override
+		{
+			return CloneElements( sourceIndex, entities, CopyMethod() );
+		}
+
+		bool IsCopyable() const override
+		{
+			return CopyMethod::value != 0;
+		}
+
+		void Freeze( uint32_t index, std::vector<uint8_t>& bytes ) override
+		{
+			Freeze( index, bytes, BitwiseCopy() );
+		}
+
+		bool Thaw( EntityId entityId, const uint8_t*& bytes ) override
+		{
+			return Thaw( entityId, bytes, BitwiseCopy() );
+		}
+
+		void DiscardFrozen( EntityId entityId, const uint8_t*& bytes ) override
+		{
+			DiscardFrozen( entityId, bytes, BitwiseCopy() );
+		}
+
+	protected:
+		uint32_t ComputeChunkChecksum( size_t chunkIndex ) const override
+		{
+			const size_t first = chunkIndex * COMPONENT_CHUNK_CAPACITY;
+			const size_t count = std::min( COMPONENT_CHUNK_CAPACITY, m_size - first );
+
+			const uint64_t chunk = chunkIndex;
+			uint32_t crc = crc32_update( &chunk, sizeof( chunk ) );
+			crc = crc32_update( &m_entities[first], count * sizeof( EntityId ), crc );
+			crc = ComponentChecksum<T>::Update( crc, Get( first ), count );
+
+			return crc ^ 0xFFFFFFFF;
+		}
+
+	private:
+		// Components are copied and stored as plain bytes when their type allows it
+		using BitwiseCopy = std::integral_constant<bool, ComponentReflection<T>::bTriviallyCopyable>;
+
+		// Holds the hibernating components that cannot be stored as bytes, created on first use
+		ComponentPool<T>*	m_coldPool;
+
+		void Freeze( uint32_t index, std::vector<uint8_t>& bytes, std::true_type )
+		{
+			const uint8_t* element = static_cast<const uint8_t*>( GetElement( index ) );
+			bytes.insert( bytes.end(), element, element + sizeof( T ) );
+		}
+
+		void Freeze( uint32_t index, std::vector<uint8_t>&, std::false_type )
+		{
+			if( m_coldPool == nullptr )
+			{
+				m_coldPool = new ComponentPool<T>( m_allocator );
+			}
+			m_coldPool->Emplace( m_entities[index], std::move( *Get( index ) ) );
+		}
+
+		bool Thaw( EntityId entityId, const uint8_t*& bytes, std::true_type )
+		{
+			void* element = Has( entityId ) ? nullptr : PushElement( entityId );
+			if( element != nullptr )
+			{
+				std::memcpy( element, bytes, sizeof( T ) );
+			}
+			bytes += sizeof( T );
+
+			return element != nullptr;
+		}
+
+		bool Thaw( EntityId entityId, const uint8_t*&, std::false_type )
+		{
+			T* component = m_coldPool != nullptr ? m_coldPool->Find( entityId ) : nullptr;
+			if( component == nullptr )
+			{
+				return false;
+			}
+
+			const bool bThawed = Emplace( entityId, std::move( *component ) ) != nullptr;
+			m_coldPool->Remove( entityId );
+			m_coldPool->ReleaseUnusedChunks();
+
+			return bThawed;
+		}
+
+		void DiscardFrozen( EntityId, const uint8_t*& bytes, std::true_type )
+		{
+			bytes += sizeof( T );
+		}
+
+		void DiscardFrozen( EntityId entityId, const uint8_t*&, std::false_type )
+		{
+			if( m_coldPool != nullptr )
+			{
+				m_coldPool->Remove( entityId );
+				m_coldPool->ReleaseUnusedChunks();
+			}
+		}
+
+		template<typename ... Args>
+		static T* Construct( void* element, std::true_type, Args&& ... args )
+		{
+			return new( element ) T( std::forward<Args>( args ) ... );
+		}
+
+		// Plain components without a constructor are aggregate initialized, i.e. Position{ x, y, z }
+		template<typename ... Args>
+		static T* Construct( void* element, std::false_type, Args&& ... args )
+		{
+			return new( element ) T{ std::forward<Args>( args ) ... };
+		}
+
+		inline Component* GetComponent( uint32_t index, std::true_type )
+		{
+			return Get( index );
+		}
+
+		// Plain components have no Component to return
+		inline Component* GetComponent( uint32_t, std::false_type )
+		{
+			return nullptr;
+		}
+
+		// 2: copied byte by byte, 1: copy constructed, 0: cannot be copied
+		using CopyMethod = std::integral_constant<int, ComponentReflection<T>::bTriviallyCopyable ? 2 : std::is_copy_constructible<T>::value ? 1 : 0>;
+
+		template<int METHOD>
+		size_t CloneElements( uint32_t sourceIndex, const std::vector<EntityId>& entities, std::integral_constant<int, METHOD> copyMethod )
+		{
+			size_t clonedCount = 0;
+			for( const EntityId entityId : entities )
+			{
+				if( Has( entityId ) )
+				{
+					continue;
+				}
+
+				// Chunks never move, the source stays valid while the pool grows
+				void* element = PushElement( entityId );
+				if( element == nullptr )
+				{
+					break;
+				}
+
+				CopyElement( element, *Get( sourceIndex ), copyMethod );
+				++clonedCount;
+			}
+
+			return clonedCount;
+		}
+
+		size_t CloneElements( uint32_t, const std::vector<EntityId>&, std::integral_constant<int, 0> )
+		{
+			return 0;
+		}
+
+		static void CopyElement( void* element, const T& source, std::integral_constant<int, 2> )
+		{
+			std::memcpy( element, &source, sizeof( T ) );
+		}
+
+		static void CopyElement( void* element, const T& source, std::integral_constant<int, 1> )
+		{
+			new( element ) T( source );
+		}
+	};
+}
+
+#endif // !NEBULA_COMPONENTPOOL_H
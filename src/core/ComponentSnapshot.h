@@ -0,0 +1,204 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_COMPONENTSNAPSHOT_H
+#define NEBULA_COMPONENTSNAPSHOT_H
+
+#include "Constants.h"
+#include "ComponentPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace Nebula
+{
+	class ISnapshot
+	{
+	public:
+		ISnapshot() = default;
+		virtual ~ISnapshot() = default;
+
+		/*
+		*	Copies the current components into the buffer readers are not using, and makes it the published state
+		*	@return	bool:	Returns false, if a reader still holds the previous state, the publication is skipped
+		*/
+		virtual bool Publish() = 0;
+
+	private:
+		ISnapshot( const ISnapshot& ) = delete;
+		ISnapshot& operator=( const ISnapshot& ) = delete;
+		ISnapshot( ISnapshot&& ) = delete;
+		ISnapshot& operator=( ISnapshot&& ) = delete;
+	};
+
+	/*
+	*	Double-buffered copy of every component of type <T>, published by the simulation thread at the end of each world update
+	*	Any thread can read the last published state without locks through a Reader, while the simulation writes the live components
+	*	A Reader should only be held for as long as it is needed, no state is published while a reader still holds the older buffer
+	*/
+	template<typename T>
+	class ComponentSnapshot : public ISnapshot
+	{
+		struct Buffer
+		{
+			// Copies of the components, in the order of the pool at the time of publication
+			std::vector<T>			m_components;
+
+			// The owning entity of each component
+			std::vector<EntityId>	m_entities;
+
+			// Index of each entity's component, indexed by EntityId
+			std::vector<uint32_t>	m_sparse;
+
+			// The number of publications before this one
+			uint64_t				m_version;
+
+			// The number of readers holding this buffer
+			std::atomic<uint32_t>	m_readers;
+
+			Buffer() : m_version( 0 ), m_readers( 0 ) {}
+		};
+
+	public:
+		/*
+		*	A consistent view of the last published state, the view stays valid and unchanged until the reader is destroyed
+		*/
+		class Reader
+		{
+			friend class ComponentSnapshot;
+
+			const Buffer*	m_buffer;
+
+			explicit Reader( const Buffer* buffer ) : m_buffer( buffer ) {}
+
+		public:
+			// An invalid reader, with nothing published
+			Reader() : m_buffer( nullptr ) {}
+
+			Reader( Reader&& other ) : m_buffer( other.m_buffer )
+			{
+				other.m_buffer = nullptr;
+			}
+
+			~Reader()
+			{
+				if( m_buffer != nullptr )
+				{
+					const_cast<Buffer*>( m_buffer )->m_readers.fetch_sub( 1 );
+				}
+			}
+
+			// Returns false, if nothing has been published yet
+			inline bool IsValid() const { return m_buffer != nullptr; }
+
+			inline size_t GetSize() const { return m_buffer != nullptr ? m_buffer->m_components.size() : 0; }
+
+			// The published components, GetSize() of them
+			inline const T* GetComponents() const { return m_buffer != nullptr ? m_buffer->m_components.data() : nullptr; }
+
+			// The owning entity of each published component, at the same index
+			inline const EntityId* GetEntities() const { return m_buffer != nullptr ? m_buffer->m_entities.data() : nullptr; }
+
+			// The number of publications before this state, 0 for the first
+			inline uint64_t GetVersion() const { return m_buffer != nullptr ? m_buffer->m_version : 0; }
+
+			// Returns the published component of the passed entity, nullptr if the entity had no component of this type
+			const T* Find( EntityId entityId ) const
+			{
+				if( m_buffer == nullptr || entityId >= m_buffer->m_sparse.size() )
+				{
+					return nullptr;
+				}
+
+				const uint32_t index = m_buffer->m_sparse[entityId];
+				return index != IComponentPool::INVALID_INDEX ? &m_buffer->m_components[index] : nullptr;
+			}
+
+		private:
+			Reader( const Reader& ) = delete;
+			Reader& operator=( const Reader& ) = delete;
+			Reader& operator=( Reader&& ) = delete;
+		};
+
+		explicit ComponentSnapshot( const ComponentPool<T>* pool ) :
+			m_pool( pool ),
+			m_published( NONE_PUBLISHED ),
+			m_publishCount( 0 )
+		{}
+
+		bool Publish() override
+		{
+			const int published = m_published.load();
+			const int back = published == 0 ? 1 : 0;
+
+			// A reader that finds the back buffer while it is being written lets go of it, as it is not the published one
+			Buffer& buffer = m_buffers[back];
+			if( buffer.m_readers.load() != 0 )
+			{
+				return false;
+			}
+
+			const size_t size = m_pool->GetSize();
+			buffer.m_components.clear();
+			buffer.m_components.reserve( size );
+			for( size_t first = 0; first < size; first += COMPONENT_CHUNK_CAPACITY )
+			{
+				const T* chunk = m_pool->GetChunk( first / COMPONENT_CHUNK_CAPACITY );
+				buffer.m_components.insert( buffer.m_components.end(), chunk, chunk + std::min( COMPONENT_CHUNK_CAPACITY, size - first ) );
+			}
+
+			buffer.m_entities = m_pool->GetEntities();
+			buffer.m_sparse = m_pool->GetSparse();
+			buffer.m_version = m_publishCount++;
+
+			m_published.store( back );
+
+			return true;
+		}
+
+		/*
+		*	Acquires the last published state, safe to call from any thread
+		*/
+		Reader Read() const
+		{
+			for( ;; )
+			{
+				const int published = m_published.load();
+				if( published == NONE_PUBLISHED )
+				{
+					return Reader();
+				}
+
+				Buffer& buffer = m_buffers[published];
+				buffer.m_readers.fetch_add( 1 );
+
+				// The buffer might have stopped being the published one before the reader was counted
+				if( m_published.load() == published )
+				{
+					return Reader( &buffer );
+				}
+
+				buffer.m_readers.fetch_sub( 1 );
+			}
+		}
+
+	private:
+		static constexpr int NONE_PUBLISHED = -1;
+
+		// The pool the components are copied from
+		const ComponentPool<T>*	m_pool;
+
+		mutable Buffer			m_buffers[2];
+
+		// The index of the buffer readers get, NONE_PUBLISHED until the first publication
+		std::atomic<int>		m_published;
+
+		uint64_t				m_publishCount;
+	};
+
+	template<typename T>
+	constexpr int ComponentSnapshot<T>::NONE_PUBLISHED;
+}
+
+#endif // !NEBULA_COMPONENTSNAPSHOT_H
@@ -4,20 +4,52 @@
 #define NEBULA_CONSTANTS_H
 
 #include <cstdint>
+#include <cstddef>
 
 namespace Nebula 
 {
+	// Define NEBULA_ENTITY_ID_32 for 32-bit ids, halving the size of every stored EntityId, at the cost of at most 2^32 - 2 live entities per world
+#if defined( NEBULA_ENTITY_ID_32 )
+	typedef uint32_t EntityId;
+
+	typedef uint32_t ComponentId;
+#else
 	typedef uint64_t EntityId;
 
 	typedef uint64_t ComponentId;
+#endif
+
+	// The highest EntityId that can be handed out, the 0 entity id is reserved for an invalid entity id
+	static constexpr EntityId MAX_ENTITY_ID	{ static_cast<EntityId>( -1 ) - 1 };
+
+	// The number of unique component and tag types that can be represented in an entity's signature
+	static constexpr size_t MAX_COMPONENT_TYPES	{ 128 };
+
+	/*
+	*	The capacity of a World, passed to its constructor, i.e. World( WorldLimits{ 1000, 16, 32, 16000 } ) for a small test world
+	*	Limits only cap growth, storage is allocated as entities, components and systems are added
+	*/
+	struct WorldLimits
+	{
+		// The most entities alive at once, including those waiting to be cleaned up, capped at MAX_ENTITY_ID
+		size_t	m_maxEntities				= 100000;
+
+		// The most components derived from Component on a single entity, plain components are not counted
+		size_t	m_maxComponentsPerEntity	= 1000;
 
-	static constexpr size_t MAX_ENTITIES	{ 100000 };
+		// The most systems registered at once
+		size_t	m_maxSystems				= 1000;
 
-	static constexpr size_t MAX_COMPONENTS_PER_ENTITY	{ 1000 };
+		// The most components of any kind in the world at once
+		size_t	m_maxComponents				= 100000000;
+	};
 
-	static constexpr size_t MAX_SYSTEMS	{ 1000 };
+	// The number of components in a chunk of component storage, must be a power of two
+	// Chunks of every component type hold the same number of components, so the chunks of different types line up
+	static constexpr size_t COMPONENT_CHUNK_CAPACITY	{ 256 };
 
-	static constexpr size_t MAX_COMPONENTS	{ MAX_ENTITIES * MAX_COMPONENTS_PER_ENTITY };
+	// The alignment in bytes of every chunk of component storage, suitable for aligned SIMD loads and stores
+	static constexpr size_t COMPONENT_CHUNK_ALIGNMENT	{ 64 };
 }
 
 #endif // !NEBULA_CONSTANTS_H
@@ -0,0 +1,84 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#include "DynamicBuffer.h"
+
+#include <cstdlib>
+
+namespace Nebula
+{
+	constexpr size_t BufferAllocator::MIN_BLOCK_SIZE;
+	constexpr size_t BufferAllocator::MAX_CACHED_SIZE_CLASS;
+	constexpr size_t BufferAllocator::MAX_CACHED_BLOCKS;
+
+	BufferAllocator::FreeLists::~FreeLists()
+	{
+		for( auto& blocks : m_blocks )
+		{
+			for( void* block : blocks )
+			{
+				std::free( block );
+			}
+			blocks.clear();
+		}
+	}
+
+	void* BufferAllocator::Allocate( size_t size )
+	{
+		const size_t sizeClass = GetSizeClass( size );
+		if( sizeClass <= MAX_CACHED_SIZE_CLASS )
+		{
+			std::vector<void*>& blocks = GetFreeLists().m_blocks[sizeClass];
+			if( !blocks.empty() )
+			{
+				void* block = blocks.back();
+				blocks.pop_back();
+				return block;
+			}
+		}
+
+		return std::malloc( MIN_BLOCK_SIZE << sizeClass );
+	}
+
+	void BufferAllocator::Free( void* block, size_t size )
+	{
+		if( block == nullptr )
+		{
+			return;
+		}
+
+		const size_t sizeClass = GetSizeClass( size );
+		if( sizeClass <= MAX_CACHED_SIZE_CLASS )
+		{
+			std::vector<void*>& blocks = GetFreeLists().m_blocks[sizeClass];
+			if( blocks.size() < MAX_CACHED_BLOCKS )
+			{
+				blocks.push_back( block );
+				return;
+			}
+		}
+
+		std::free( block );
+	}
+
+	size_t BufferAllocator::GetBlockSize( size_t size )
+	{
+		return MIN_BLOCK_SIZE << GetSizeClass( size );
+	}
+
+	BufferAllocator::FreeLists& BufferAllocator::GetFreeLists()
+	{
+		// Each thread keeps its own blocks, allocating and releasing never waits on another thread
+		thread_local FreeLists freeLists;
+		return freeLists;
+	}
+
+	size_t BufferAllocator::GetSizeClass( size_t size )
+	{
+		size_t sizeClass = 0;
+		while( ( MIN_BLOCK_SIZE << sizeClass ) < size )
+		{
+			++sizeClass;
+		}
+		return sizeClass;
+	}
+}
@@ -0,0 +1,333 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_DYNAMICBUFFER_H
+#define NEBULA_DYNAMICBUFFER_H
+
+#include "Constants.h"
+#include "Component.h"
+#include "ComponentChecksum.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace Nebula
+{
+	/*
+	*	Hands out the overflow storage of DynamicBuffer components, in power of two size classes
+	*	Released blocks are kept by the releasing thread and handed out again by its next allocations of the same size class
+	*	Safe to call from any thread, a block may be released by another thread than the one that allocated it
+	*/
+	class BufferAllocator
+	{
+	public:
+		/*
+		*	@param	Size:		The minimum size in bytes of the block
+		*	@return	void*:		A block of GetBlockSize( size ) bytes, aligned like malloc, returns nullptr if the memory could not be allocated
+		*/
+		static void* Allocate( size_t size );
+
+		/*
+		*	Releases a block returned by Allocate, with the same size
+		*/
+		static void Free( void* block, size_t size );
+
+		// The size in bytes of the block Allocate hands out for the passed size
+		static size_t GetBlockSize( size_t size );
+
+	private:
+		// The blocks released by a single thread, one list per size class
+		struct FreeLists
+		{
+			~FreeLists();
+
+			std::vector<void*>	m_blocks[32];
+		};
+
+		static FreeLists& GetFreeLists();
+
+		// The size class of the passed size, MIN_BLOCK_SIZE << sizeClass bytes
+		static size_t GetSizeClass( size_t size );
+
+		static constexpr size_t MIN_BLOCK_SIZE = 64;
+
+		// Blocks past this size class are not kept around once they are released
+		static constexpr size_t MAX_CACHED_SIZE_CLASS = 16;
+
+		// The number of released blocks kept by a thread, per size class
+		static constexpr size_t MAX_CACHED_BLOCKS = 64;
+	};
+
+	/*
+	*	A variable-length array component, i.e. DynamicBuffer<Waypoint, 8>, an entity can only have one buffer of each type
+	*	The first <INLINE_CAPACITY> elements are stored inside of the component itself, in chunk storage along with the other components
+	*	Larger buffers move their elements into a block of the BufferAllocator, and move them back with ShrinkToFit
+	*	The elements are always contiguous, systems iterate them as a span between begin() and end()
+	*	@param	<T>:				The element type, must be trivially copyable, elements are moved around as plain memory
+	*	@param	<INLINE_CAPACITY>:	The number of elements stored without an allocation
+	*/
+	template<typename T, size_t INLINE_CAPACITY = 8>
+	class DynamicBuffer
+	{
+		static_assert( std::is_trivially_copyable<T>::value, "DynamicBuffer elements must be trivially copyable" );
+		static_assert( alignof( T ) <= alignof( std::max_align_t ), "DynamicBuffer elements cannot be over-aligned" );
+		static_assert( INLINE_CAPACITY > 0, "DynamicBuffer requires an inline capacity of at least one element" );
+
+	public:
+		DynamicBuffer() :
+			m_size( 0 ),
+			m_capacity( static_cast<uint32_t>( INLINE_CAPACITY ) ),
+			m_overflow( nullptr )
+		{}
+
+		// Builds the buffer from a list of elements, i.e. AddComponentToEntity<DynamicBuffer<Waypoint>>( entityId, { a, b, c } )
+		DynamicBuffer( std::initializer_list<T> elements ) : DynamicBuffer()
+		{
+			if( Reserve( elements.size() ) )
+			{
+				std::memcpy( GetData(), elements.begin(), elements.size() * sizeof( T ) );
+				m_size = static_cast<uint32_t>( elements.size() );
+			}
+		}
+
+		DynamicBuffer( const DynamicBuffer& other ) : DynamicBuffer()
+		{
+			if( Reserve( other.m_size ) )
+			{
+				std::memcpy( GetData(), other.GetData(), other.m_size * sizeof( T ) );
+				m_size = other.m_size;
+			}
+		}
+
+		// Components are moved between the slots of their ComponentPool, the overflow block moves along without a copy
+		DynamicBuffer( DynamicBuffer&& other ) :
+			m_size( other.m_size ),
+			m_capacity( other.m_capacity ),
+			m_overflow( other.m_overflow )
+		{
+			if( m_overflow == nullptr )
+			{
+				std::memcpy( &m_inline, &other.m_inline, m_size * sizeof( T ) );
+			}
+
+			other.m_size = 0;
+			other.m_capacity = static_cast<uint32_t>( INLINE_CAPACITY );
+			other.m_overflow = nullptr;
+		}
+
+		DynamicBuffer& operator=( const DynamicBuffer& other )
+		{
+			if( this != &other )
+			{
+				m_size = 0;
+				if( Reserve( other.m_size ) )
+				{
+					std::memcpy( GetData(), other.GetData(), other.m_size * sizeof( T ) );
+					m_size = other.m_size;
+				}
+			}
+			return *this;
+		}
+
+		DynamicBuffer& operator=( DynamicBuffer&& other )
+		{
+			if( this != &other )
+			{
+				this->~DynamicBuffer();
+				new( this ) DynamicBuffer( std::move( other ) );
+			}
+			return *this;
+		}
+
+		~DynamicBuffer()
+		{
+			if( m_overflow != nullptr )
+			{
+				BufferAllocator::Free( m_overflow, m_capacity * sizeof( T ) );
+			}
+		}
+
+		inline size_t GetSize() const { return m_size; }
+
+		inline size_t GetCapacity() const { return m_capacity; }
+
+		inline bool IsEmpty() const { return m_size == 0; }
+
+		// Returns false, if the elements have moved out of the component into an overflow block
+		inline bool IsInline() const { return m_overflow == nullptr; }
+
+		inline T* GetData() { return m_overflow != nullptr ? m_overflow : reinterpret_cast<T*>( &m_inline ); }
+
+		inline const T* GetData() const { return m_overflow != nullptr ? m_overflow : reinterpret_cast<const T*>( &m_inline ); }
+
+		inline T* begin() { return GetData(); }
+		inline T* end() { return GetData() + m_size; }
+		inline const T* begin() const { return GetData(); }
+		inline const T* end() const { return GetData() + m_size; }
+
+		inline T& operator[]( size_t index ) { return GetData()[index]; }
+		inline const T& operator[]( size_t index ) const { return GetData()[index]; }
+
+		/*
+		*	Appends a copy of the passed element
+		*	@return	bool:	Returns false, if the buffer needed to grow and the memory could not be allocated
+		*/
+		bool PushBack( const T& element )
+		{
+			if( m_size == m_capacity && !Reserve( static_cast<size_t>( m_capacity ) * 2 ) )
+			{
+				return false;
+			}
+
+			GetData()[m_size++] = element;
+			return true;
+		}
+
+		// Removes the last element, if there is one
+		void PopBack()
+		{
+			if( m_size > 0 )
+			{
+				--m_size;
+			}
+		}
+
+		// Removes the element at the passed index, the following elements move down by one
+		void RemoveAt( size_t index )
+		{
+			if( index >= m_size )
+			{
+				return;
+			}
+
+			T* data = GetData();
+			std::memmove( data + index, data + index + 1, ( m_size - index - 1 ) * sizeof( T ) );
+			--m_size;
+		}
+
+		// Removes the element at the passed index, the last element takes its place
+		void RemoveAtSwapBack( size_t index )
+		{
+			if( index >= m_size )
+			{
+				return;
+			}
+
+			T* data = GetData();
+			data[index] = data[m_size - 1];
+			--m_size;
+		}
+
+		// Removes all elements, the capacity is kept
+		inline void Clear() { m_size = 0; }
+
+		/*
+		*	Makes room for at least the passed number of elements, moving the elements into an overflow block if they no longer fit
+		*	@return	bool:	Returns false, if the memory could not be allocated, the buffer is then left unchanged
+		*/
+		bool Reserve( size_t capacity )
+		{
+			if( capacity <= m_capacity )
+			{
+				return true;
+			}
+
+			if( capacity > UINT32_MAX )
+			{
+				return false;
+			}
+
+			const size_t blockSize = BufferAllocator::GetBlockSize( capacity * sizeof( T ) );
+			T* overflow = static_cast<T*>( BufferAllocator::Allocate( blockSize ) );
+			if( overflow == nullptr )
+			{
+				return false;
+			}
+
+			std::memcpy( overflow, GetData(), m_size * sizeof( T ) );
+			if( m_overflow != nullptr )
+			{
+				BufferAllocator::Free( m_overflow, m_capacity * sizeof( T ) );
+			}
+
+			m_overflow = overflow;
+			m_capacity = static_cast<uint32_t>( std::min<size_t>( blockSize / sizeof( T ), UINT32_MAX ) );
+			return true;
+		}
+
+		/*
+		*	Changes the number of elements, new elements are value-initialized
+		*	@return	bool:	Returns false, if the memory could not be allocated
+		*/
+		bool Resize( size_t size )
+		{
+			if( !Reserve( size ) )
+			{
+				return false;
+			}
+
+			T* data = GetData();
+			for( size_t i = m_size; i < size; ++i )
+			{
+				new( data + i ) T();
+			}
+			m_size = static_cast<uint32_t>( size );
+			return true;
+		}
+
+		// Moves the elements back inside of the component when they fit, releasing the overflow block
+		void ShrinkToFit()
+		{
+			if( m_overflow == nullptr || m_size > INLINE_CAPACITY )
+			{
+				return;
+			}
+
+			T* overflow = m_overflow;
+			std::memcpy( &m_inline, overflow, m_size * sizeof( T ) );
+			BufferAllocator::Free( overflow, m_capacity * sizeof( T ) );
+
+			m_overflow = nullptr;
+			m_capacity = static_cast<uint32_t>( INLINE_CAPACITY );
+		}
+
+	private:
+		uint32_t	m_size;
+
+		uint32_t	m_capacity;
+
+		// The elements once they no longer fit inline, nullptr while they are stored inline
+		T*			m_overflow;
+
+		typename std::aligned_storage<sizeof( T ) * INLINE_CAPACITY, alignof( T )>::type	m_inline;
+	};
+
+	// Buffers are not trivially copyable, but copy and move their elements as plain memory
+	template<typename T, size_t INLINE_CAPACITY>
+	struct IsComponent< DynamicBuffer<T, INLINE_CAPACITY> >
+	{
+		static constexpr bool value = true;
+	};
+
+	// The size and elements of each buffer are hashed, wherever the elements are stored
+	template<typename T, size_t INLINE_CAPACITY>
+	struct ComponentChecksum< DynamicBuffer<T, INLINE_CAPACITY> >
+	{
+		static uint32_t Update( uint32_t crc, const DynamicBuffer<T, INLINE_CAPACITY>* components, size_t count )
+		{
+			for( size_t i = 0; i < count; ++i )
+			{
+				const uint64_t size = components[i].GetSize();
+				crc = crc32_update( &size, sizeof( size ), crc );
+				crc = crc32_update( components[i].GetData(), components[i].GetSize() * sizeof( T ), crc );
+			}
+			return crc;
+		}
+	};
+}
+
+#endif // !NEBULA_DYNAMICBUFFER_H
@@ -4,8 +4,9 @@
 #define NEBULA_ENTITY_H
 
 #include "Constants.h"
+#include "Signature.h"
 
-#include <array>
+#include <vector>
 
 namespace Nebula
 {
@@ -19,12 +20,13 @@ namespace Nebula
 		Entity& operator=( const Entity& ) = delete;
 		Entity& operator=(Entity&&) = delete;
 		
-		Entity() : m_entityId( 0 ), m_componentCounter( 0 ), m_components(), m_bMarkedForCleanUp(false) {}
+		Entity() : m_entityId( 0 ), m_componentCounter( 0 ), m_components(), m_signature(), m_bMarkedForCleanUp(false) {}
 		~Entity() = default;	
 
 		inline const EntityId& GetId() const { return m_entityId; }
 		inline const uint64_t& GetComponentCount() const { return m_componentCounter; }
-		inline const std::array<class Component*, MAX_COMPONENTS_PER_ENTITY>& GetComponents() const { return m_components; }
+		inline const std::vector<class Component*>& GetComponents() const { return m_components; }
+		inline const Signature& GetSignature() const { return m_signature; }
 
 		friend bool operator== ( const Entity& e1, const Entity& e2 )
 		{
@@ -44,11 +46,15 @@ namespace Nebula
 		// Unique identifier for this entity
 		EntityId			m_entityId;
 
-		// Number of components on this entity
+		// Number of components derived from Component on this entity
 		uint64_t			m_componentCounter;
 
-		// Components attached to this entity
-		std::array<Component*, MAX_COMPONENTS_PER_ENTITY> m_components;
+		// Components derived from Component attached to this entity, plain components are only stored in their pools
+		// Indexed by the ComponentId of each component, grows as components are attached up to WorldLimits::m_maxComponentsPerEntity
+		std::vector<Component*> m_components;
+
+		// The component and tag types present on this entity
+		Signature			m_signature;
 
 		// Used to determine when an entity has been marked for clean up by the EntityManager
 		bool				m_bMarkedForCleanUp;
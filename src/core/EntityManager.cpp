@@ -2,16 +2,17 @@
 
 #include "EntityManager.h"
 
+#include <algorithm>
+
 namespace Nebula
 {
-	EntityManager::EntityManager() :
-		m_entityCounter( 0 )
-	{
-		for( uint64_t i = 0; i < MAX_ENTITIES; ++i )
-		{
-			m_entityPool.CreateNewObjectInPool();
-		}
-	}
+	EntityManager::EntityManager( size_t maxEntities ) :
+		m_entityCounter( 0 ),
+		m_lastEntityId( 0 ),
+		m_freeEntityIdsTaken( 0 ),
+		m_reservableEntityCount( std::min<uint64_t>( maxEntities, MAX_ENTITY_ID ) ),
+		m_disabledEntityCount( 0 )
+	{}
 
 	EntityManager::~EntityManager()
 	{
@@ -21,39 +22,71 @@ namespace Nebula
 
 	EntityId EntityManager::CreateEntity()
 	{
+		const EntityId entityId = ReserveEntityId();
 
-		/* '>' check works for entity counter, because the 0 entity id is reserved for an invalid entity id, and an entity id is incremented as its assigned*/
-		if( m_entityCounter > MAX_ENTITIES )
+		if( entityId == 0 || !CreateReservedEntity( entityId ) )
 		{
 			return 0;
 		}
 
+		return entityId;
+	}
+
+	EntityId EntityManager::ReserveEntityId()
+	{
+		// Claim one of the remaining entities first, so every reserved EntityId is guaranteed an entity
+		uint64_t reservableCount = m_reservableEntityCount.load( std::memory_order_relaxed );
+		do
+		{
+			if( reservableCount == 0 )
+			{
+				return 0;
+			}
+		}
+		while( !m_reservableEntityCount.compare_exchange_weak( reservableCount, reservableCount - 1, std::memory_order_relaxed ) );
+
+		// Reuse the EntityId of a cleaned up entity when possible, the free list only changes while no ids are being reserved
+		const size_t freeIndex = m_freeEntityIdsTaken.fetch_add( 1, std::memory_order_relaxed );
+		if( freeIndex < m_freeEntityIds.size() )
+		{
+			return m_freeEntityIds[m_freeEntityIds.size() - 1 - freeIndex];
+		}
+
+		// The 0 entity id is reserved for an invalid entity id
+		return m_lastEntityId.fetch_add( 1, std::memory_order_relaxed ) + 1;
+	}
+
+	bool EntityManager::CreateReservedEntity( EntityId entityId )
+	{
 		Entity* entity = GetNewEntity();
 
 		if( entity == nullptr )
 		{
-			return 0;
+			return false;
 		}
 
-		entity->m_entityId = ++m_entityCounter;
-		m_entities[m_entityCounter] = entity;
+		entity->m_entityId = entityId;
 
-		return m_entityCounter;
+		m_entities[entity->m_entityId] = entity;
+		++m_entityCounter;
 
+		return true;
 	}
 
 
 	bool EntityManager::MarkEntityForCleanUp( EntityId entityId )
 	{
-		Entity* entity = m_entities[entityId];
+		const auto it = m_entities.find( entityId );
 
 		// Entity does not exist, returning
-		if( entity == nullptr )
+		if( it == m_entities.end() || it->second == nullptr )
 		{
 			return false;
 		}
 
-		m_entities.erase( entityId );
+		Entity* entity = it->second;
+
+		m_entities.erase( it );
 
 		MarkEntityForCleanUp( entity );
 
@@ -62,69 +95,123 @@ namespace Nebula
 		return true;
 	}
 
+	bool EntityManager::SetEntityEnabled( EntityId entityId, bool bEnabled )
+	{
+		if( m_entities.find( entityId ) == m_entities.end() )	// Entity does not exist
+		{
+			return false;
+		}
+
+		SetDisabled( entityId, !bEnabled );
+		return true;
+	}
+
+	EntityId EntityManager::GetNextEntityMarkedForCleanUp() const
+	{
+		return m_entitiesMarkedForCleanUp.empty() ? 0 : m_entitiesMarkedForCleanUp.back()->m_entityId;
+	}
+
+	void EntityManager::CleanUpNextEntity()
+	{
+		if( m_entitiesMarkedForCleanUp.empty() )
+		{
+			return;
+		}
+
+		Entity* entity = m_entitiesMarkedForCleanUp.back();
+		m_entitiesMarkedForCleanUp.pop_back();
+
+		CompactFreeEntityIds();
+		m_freeEntityIds.push_back( entity->m_entityId );
+
+		entity->m_entityId = 0;
+		entity->m_componentCounter = 0;
+		entity->m_components.clear();
+		entity->m_signature.reset();
+		entity->m_bMarkedForCleanUp = false;
+
+		m_entityPool.ReturnObject( entity );
+		m_reservableEntityCount.fetch_add( 1, std::memory_order_relaxed );
+	}
+
+	void EntityManager::CompactFreeEntityIds()
+	{
+		const size_t takenCount = std::min( m_freeEntityIdsTaken.exchange( 0, std::memory_order_relaxed ), m_freeEntityIds.size() );
+		m_freeEntityIds.resize( m_freeEntityIds.size() - takenCount );
+	}
+
 	void EntityManager::MarkEntityForCleanUp( Entity* entity )
 	{
 		entity->m_bMarkedForCleanUp = true;
-		entity->m_entityId = 0;
+		entity->m_signature.reset();
 		m_entitiesMarkedForCleanUp.push_back( entity );
+
+		// The next entity given this EntityId starts out enabled
+		SetDisabled( entity->m_entityId, false );
 	}
 
-	void EntityManager::MarkAllEntitiesForCleanUp()
+	void EntityManager::SetDisabled( EntityId entityId, bool bDisabled )
 	{
-		Entity* entity = nullptr;
-		for( uint64_t i = 0; i < m_entityCounter; i++ )
-		{
-			entity = m_entities[i];
+		const size_t word = entityId / 64;
+		const uint64_t bit = uint64_t( 1 ) << ( entityId % 64 );
 
-			// Entity does not exist, returning
-			if( entity == nullptr )
+		if( word >= m_disabledEntities.size() )
+		{
+			if( !bDisabled )
 			{
 				return;
 			}
+			m_disabledEntities.resize( word + 1, 0 );
+		}
 
-			MarkEntityForCleanUp( entity );
+		if( ( ( m_disabledEntities[word] & bit ) != 0 ) == bDisabled )	// Nothing changes
+		{
+			return;
+		}
+
+		m_disabledEntities[word] ^= bit;
+		if( bDisabled )
+		{
+			++m_disabledEntityCount;
+		}
+		else
+		{
+			--m_disabledEntityCount;
 		}
-		m_entities.clear();
-		m_entityCounter = 0;
 	}
 
-	Entity* EntityManager::GetNewEntity()
+	void EntityManager::MarkAllEntitiesForCleanUp()
 	{
-		Entity* entity = nullptr;
-
-		size_t numEntitiesMarkedForCleanUp = m_entitiesMarkedForCleanUp.size();
-		if( numEntitiesMarkedForCleanUp > 0 )
+		for( const auto& entity : m_entities )
 		{
-			// Grab the last index of entities marked for clean up
-			entity = m_entitiesMarkedForCleanUp[numEntitiesMarkedForCleanUp - 1];
-			entity->m_bMarkedForCleanUp = false;
-			m_entitiesMarkedForCleanUp.pop_back();
-			return entity;
+			if( entity.second != nullptr )
+			{
+				MarkEntityForCleanUp( entity.second );
+			}
 		}
+		m_entities.clear();
+		m_entityCounter = 0;
+	}
 
-		// Otherwise, grab an entity from the entity pool
-		entity = m_entityPool.GetObject();
-
+	Entity* EntityManager::GetNewEntity()
+	{
+		// Entities are only reused once they have been cleaned up and returned to the entity pool, the pool grows when none is left
+		// Every reserved EntityId was guaranteed an entity by 'm_reservableEntityCount', the limit is not checked again here
+		Entity* entity = m_entityPool.GetObject();
 		if( entity == nullptr )
 		{
-			return nullptr;
+			m_entityPool.CreateNewObjectInPool();
+			entity = m_entityPool.GetObject();
 		}
-
 		return entity;
 	}
 
 	void EntityManager::CleanUpEntities()
 	{
-		Entity* entity = nullptr;
-		size_t numEntitiesMarkedForCleanUp = m_entitiesMarkedForCleanUp.size();
-		for( int i = 0; i < numEntitiesMarkedForCleanUp; ++i )
+		while( !m_entitiesMarkedForCleanUp.empty() )
 		{
-			if( m_entitiesMarkedForCleanUp[i] != nullptr )
-				m_entitiesMarkedForCleanUp[i]->m_bMarkedForCleanUp = false;
-
-			m_entityPool.ReturnObject( m_entitiesMarkedForCleanUp[i] );
+			CleanUpNextEntity();
 		}
-		m_entitiesMarkedForCleanUp.clear();
 	}
 
-};
\ No newline at end of file
+};
@@ -6,6 +6,7 @@
 #include "Entity.h"
 #include "../utility/ObjectPool.h"
 
+#include <atomic>
 #include <map>
 #include <vector>
 
@@ -27,15 +28,38 @@ namespace Nebula
 		// The number of entities in this entity manager
 		uint64_t				m_entityCounter;
 
+		// The highest EntityId handed out by this entity manager
+		std::atomic<EntityId>	m_lastEntityId;
+
+		// EntityIds of cleaned up entities, ready to be handed out again, taken from the back
+		std::vector<EntityId>	m_freeEntityIds;
+
+		// The number of EntityIds reserved from the back of 'm_freeEntityIds' since it was last compacted, may exceed its size
+		std::atomic<size_t>		m_freeEntityIdsTaken;
+
+		// The number of entities that can still be reserved, before the world's entity limit is reached
+		std::atomic<uint64_t>	m_reservableEntityCount;
+
 		// Entities that have been removed from the 'm_entities' map and have been marked for clean up
+		// They keep their EntityId until they are cleaned up, so the id cannot be reused while their components still exist
 		std::vector<Entity*>	m_entitiesMarkedForCleanUp;
 
-		// Object pool used to manage the creation and deletion of entities
+		// One bit per EntityId, set for disabled entities
+		// Disabled entities keep their components and stay in their systems, but are skipped when systems iterate them
+		std::vector<uint64_t>	m_disabledEntities;
+
+		// The number of bits set in 'm_disabledEntities'
+		size_t					m_disabledEntityCount;
+
+		// Object pool used to manage the creation and deletion of entities, grown one entity at a time as needed
 		ObjectPool<Entity>		m_entityPool;
 
 	public:
 
-		EntityManager();
+		/*
+		*	@param	MaxEntities:	The most entities alive at once, see WorldLimits::m_maxEntities
+		*/
+		explicit EntityManager( size_t maxEntities = WorldLimits().m_maxEntities );
 		~EntityManager();
 
 		/*
@@ -43,6 +67,19 @@ namespace Nebula
 		*	@return	EntityId:	The EntityId of the created entity, if an Entity could not be created an EntityId of 0 will be returned
 		*/
 		EntityId CreateEntity();
+
+		/*
+		*	Reserves an EntityId without creating its entity, lock-free and safe to call from any thread
+		*	The entity must be created on the main thread with CreateReservedEntity
+		*	@return	EntityId:	The reserved EntityId, 0 if the entity limit has been reached
+		*/
+		EntityId ReserveEntityId();
+
+		/*
+		*	Creates the entity of an EntityId returned by ReserveEntityId
+		*	@return	bool:	Returns true, if the entity was created
+		*/
+		bool CreateReservedEntity( EntityId entityId );
 		
 		/*
 		*	Marks the Entity with the identical EntityId that has been passed for clean up
@@ -51,6 +88,35 @@ namespace Nebula
 		*/
 		bool MarkEntityForCleanUp( EntityId entityId );
 
+		/*
+		*	@return	EntityId:	The EntityId of the next entity that will be cleaned up by CleanUpNextEntity, 0 if no entity is marked for clean up
+		*/
+		EntityId GetNextEntityMarkedForCleanUp() const;
+
+		/*
+		*	Cleans up the next entity marked for clean up, returning the entity to the entity pool and its EntityId to the free list
+		*	The components of the entity must have been cleaned up beforehand
+		*/
+		void CleanUpNextEntity();
+
+		inline size_t GetEntitiesMarkedForCleanUpCount() const { return m_entitiesMarkedForCleanUp.size(); }
+
+		/*
+		*	Enables or disables the entity with the passed EntityId, without touching its components or its systems
+		*	Entities are enabled when created, destroying an entity enables its EntityId again
+		*	@return	bool:	Returns true, if the entity exists
+		*/
+		bool SetEntityEnabled( EntityId entityId, bool bEnabled );
+
+		inline bool IsEntityEnabled( EntityId entityId ) const
+		{
+			const size_t word = entityId / 64;
+			return word >= m_disabledEntities.size() || ( m_disabledEntities[word] & ( uint64_t( 1 ) << ( entityId % 64 ) ) ) == 0;
+		}
+
+		// Returns false, if every entity is enabled, iteration can then skip the checks
+		inline bool HasDisabledEntities() const { return m_disabledEntityCount != 0; }
+
 	private:
 
 		/*
@@ -59,6 +125,16 @@ namespace Nebula
 		*/
 		void MarkEntityForCleanUp( Entity* entity );
 
+		/*
+		*	Sets or clears the disabled bit of the passed EntityId
+		*/
+		void SetDisabled( EntityId entityId, bool bDisabled );
+
+		/*
+		*	Removes the EntityIds that have been reserved from the free list, not safe while ids are being reserved
+		*/
+		void CompactFreeEntityIds();
+
 		/*
 		*	Marks all live entities for clean up
 		*/
@@ -70,7 +146,7 @@ namespace Nebula
 		Entity* GetNewEntity();
 
 		/*
-		*	Cleans up the entities marked for clean up
+		*	Cleans up all the entities marked for clean up
 		*/
 		void CleanUpEntities();
 
@@ -0,0 +1,271 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_EVENTBUS_H
+#define NEBULA_EVENTBUS_H
+
+#include "../utility/ThreadLocalSlot.h"
+#include "../utility/TypeIndex.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Nebula
+{
+	// The number of event types an EventBus can hold
+	static constexpr size_t MAX_EVENT_TYPES	{ 256 };
+
+	/*
+	*	A read-only view of contiguous events, valid until the next EventBus::SwapBuffers
+	*/
+	template<typename T>
+	struct EventSpan
+	{
+		EventSpan() : m_data( nullptr ), m_size( 0 ) {}
+
+		EventSpan( const T* data, size_t size ) : m_data( data ), m_size( size ) {}
+
+		inline const T* begin() const { return m_data; }
+		inline const T* end() const { return m_data + m_size; }
+
+		inline const T& operator[]( size_t index ) const { return m_data[index]; }
+
+		inline const T* GetData() const { return m_data; }
+
+		inline size_t GetSize() const { return m_size; }
+
+		inline bool IsEmpty() const { return m_size == 0; }
+
+	private:
+		const T*	m_data;
+		size_t		m_size;
+	};
+
+	/*
+	*	Type-erased event queue, its buffers are swapped once per world update
+	*/
+	class IEventQueue
+	{
+	public:
+		IEventQueue() = default;
+		virtual ~IEventQueue() = default;
+
+		virtual void SwapBuffers() = 0;
+
+	private:
+		IEventQueue( const IEventQueue& ) = delete;
+		IEventQueue& operator=( const IEventQueue& ) = delete;
+		IEventQueue( IEventQueue&& ) = delete;
+		IEventQueue& operator=( IEventQueue&& ) = delete;
+	};
+
+	/*
+	*	The events of type <T>, written during one update and read during the next
+	*	Each writing thread appends to its own segment without synchronization, the segments are gathered into one contiguous array by SwapBuffers
+	*	A thread finds its segment through a ThreadLocalSlot in constant time, and forgets it along with the queue
+	*	@param	<T>:	The event type, a plain value type, i.e. struct DamageEvent { EntityId m_target; float m_amount; };
+	*/
+	template<typename T>
+	class EventQueue : public IEventQueue
+	{
+		// The events written by a single thread since the last swap
+		struct Segment
+		{
+			std::vector<T>	m_events;
+		};
+
+	public:
+		EventQueue() :
+			m_segmentSlot()
+		{}
+
+		~EventQueue() override
+		{
+			for( auto* segment : m_segments )
+			{
+				delete segment;
+			}
+			m_segments.clear();
+		}
+
+		/*
+		*	Appends an event to the calling thread's segment, safe to call from any thread while the buffers are not being swapped
+		*/
+		template<typename ... Args>
+		void Send( Args&& ... args )
+		{
+			GetSegment().m_events.emplace_back( std::forward<Args>( args ) ... );
+		}
+
+		// The events written before the last swap, in the order of their writing threads' first event ever, then in the order they were written
+		inline EventSpan<T> Read() const { return EventSpan<T>( m_events.data(), m_events.size() ); }
+
+		/*
+		*	Gathers the events of every segment into the read buffer, dropping the events read so far
+		*	Must be called while no thread is writing or reading events
+		*/
+		void SwapBuffers() override
+		{
+			std::lock_guard<std::mutex> lock( m_segmentsMutex );
+
+			m_events.clear();
+
+			size_t count = 0;
+			Segment* onlySegment = nullptr;
+			for( Segment* segment : m_segments )
+			{
+				if( !segment->m_events.empty() )
+				{
+					onlySegment = count == 0 ? segment : nullptr;
+					count += segment->m_events.size();
+				}
+			}
+
+			// A single writer hands its events over as they are, and gets the storage of the old read buffer in return
+			if( onlySegment != nullptr )
+			{
+				m_events.swap( onlySegment->m_events );
+				return;
+			}
+
+			m_events.reserve( count );
+			for( Segment* segment : m_segments )
+			{
+				m_events.insert( m_events.end(), std::make_move_iterator( segment->m_events.begin() ), std::make_move_iterator( segment->m_events.end() ) );
+				segment->m_events.clear();
+			}
+		}
+
+	private:
+		Segment& GetSegment()
+		{
+			Segment* segment = static_cast<Segment*>( m_segmentSlot.Get() );
+			if( segment != nullptr )
+			{
+				return *segment;
+			}
+
+			segment = new Segment();
+			{
+				std::lock_guard<std::mutex> lock( m_segmentsMutex );
+				m_segments.push_back( segment );
+			}
+			m_segmentSlot.Set( segment );
+
+			return *segment;
+		}
+
+		// Holds each thread's segment of this queue
+		ThreadLocalSlot			m_segmentSlot;
+
+		// The events of the previous update, contiguous
+		std::vector<T>			m_events;
+
+		// The segment of every thread that has written to this queue
+		std::vector<Segment*>	m_segments;
+
+		// Guards 'm_segments', only taken the first time a thread writes to this queue, and by SwapBuffers
+		std::mutex				m_segmentsMutex;
+	};
+
+	/*
+	*	The typed event queues of a World, systems talk to each other through events instead of marker components or globals
+	*	Events written during an update are read during the next one, see World::SendEvent and World::ReadEvents
+	*	Event types are looked up through the dense index of their type, no searching, casting or virtual calls are involved per event
+	*/
+	class EventBus
+	{
+	public:
+		EventBus()
+		{
+			for( auto& queue : m_queues )
+			{
+				queue.store( nullptr, std::memory_order_relaxed );
+			}
+		}
+
+		~EventBus()
+		{
+			for( auto& queue : m_queues )
+			{
+				delete queue.load( std::memory_order_relaxed );
+			}
+		}
+
+		/*
+		*	@return	EventQueue<T>*:		The queue of the passed event type, created on first use, safe to call from any thread
+		*								Returns nullptr, if MAX_EVENT_TYPES event types are already in use
+		*/
+		template<typename T>
+		EventQueue<T>* GetQueue()
+		{
+			const size_t index = GetEventIndex<T>();
+			if( index >= MAX_EVENT_TYPES )
+			{
+				return nullptr;
+			}
+
+			IEventQueue* queue = m_queues[index].load( std::memory_order_acquire );
+			if( queue == nullptr )
+			{
+				// Racing threads each create a queue, only the first one is kept
+				IEventQueue* createdQueue = new EventQueue<T>();
+				if( m_queues[index].compare_exchange_strong( queue, createdQueue, std::memory_order_acq_rel ) )
+				{
+					queue = createdQueue;
+				}
+				else
+				{
+					delete createdQueue;
+				}
+			}
+
+			return static_cast< EventQueue<T>* >( queue );
+		}
+
+		/*
+		*	@return	EventQueue<T>*:		The queue of the passed event type, nullptr if no event of this type was ever sent or read
+		*/
+		template<typename T>
+		const EventQueue<T>* FindQueue() const
+		{
+			const size_t index = GetEventIndex<T>();
+			return index < MAX_EVENT_TYPES ? static_cast< const EventQueue<T>* >( m_queues[index].load( std::memory_order_acquire ) ) : nullptr;
+		}
+
+		/*
+		*	Makes the events written since the last swap readable, in every queue, called by World::Update once all systems are done
+		*/
+		void SwapBuffers()
+		{
+			for( auto& queue : m_queues )
+			{
+				IEventQueue* eventQueue = queue.load( std::memory_order_acquire );
+				if( eventQueue != nullptr )
+				{
+					eventQueue->SwapBuffers();
+				}
+			}
+		}
+
+	private:
+		EventBus( const EventBus& ) = delete;
+		EventBus& operator=( const EventBus& ) = delete;
+		EventBus( EventBus&& ) = delete;
+		EventBus& operator=( EventBus&& ) = delete;
+
+		template<typename T>
+		static size_t GetEventIndex()
+		{
+			return TypeIndex<EventBus>::Get<T>();
+		}
+
+		// The queue of each event type, indexed by the TypeIndex of the event type
+		std::atomic<IEventQueue*>	m_queues[MAX_EVENT_TYPES];
+	};
+}
+
+#endif // !NEBULA_EVENTBUS_H
@@ -0,0 +1,282 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_FIELDINDEX_H
+#define NEBULA_FIELDINDEX_H
+
+#include "Constants.h"
+
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace Nebula
+{
+	/*
+	*	Looks up entities by the value of a field of one of their components, kept up to date by the ComponentManager
+	*	Each index remembers the value every entity was filed under, components can therefore change in place
+	*	The index only sees a change once the ComponentManager is notified of it, see ComponentManager::NotifyComponentChanged
+	*/
+	class IFieldIndex
+	{
+	public:
+		IFieldIndex() = default;
+		virtual ~IFieldIndex() = default;
+
+		/*
+		*	Files the entity under the current value of the field of the passed component, moving it if it was filed under another value
+		*	@param	EntityId:		The owner of the component
+		*	@param	Component:		The component of the indexed type
+		*/
+		virtual void Insert( EntityId entityId, const void* component ) = 0;
+
+		/*
+		*	Removes the entity from this index, if it is indexed
+		*/
+		virtual void Erase( EntityId entityId ) = 0;
+
+		// The number of indexed entities
+		virtual size_t GetSize() const = 0;
+
+		// Returns true, if prefabs are indexed along with other entities
+		virtual bool IndexesPrefabs() const { return false; }
+
+		/*
+		*	The entity is about to hibernate, it is erased from this index while its component is frozen, see ComponentManager::Hibernate
+		*	Called while the component is still in its pool
+		*/
+		virtual void OnHibernate( EntityId ) {}
+
+		/*
+		*	The entity woke up and was inserted again, or was destroyed while hibernating
+		*/
+		virtual void OnWake( EntityId ) {}
+
+	private:
+		IFieldIndex( const IFieldIndex& ) = delete;
+		IFieldIndex& operator=( const IFieldIndex& ) = delete;
+		IFieldIndex( IFieldIndex&& ) = delete;
+		IFieldIndex& operator=( IFieldIndex&& ) = delete;
+	};
+
+	/*
+	*	Finds the entities whose component <T> holds a given value, in constant time
+	*	@param	<T>:		The component type
+	*	@param	<Key>:		The type of the indexed field, must be usable as the key of a std::unordered_map
+	*/
+	template<typename T, typename Key, typename Hash = std::hash<Key>>
+	class HashIndex : public IFieldIndex
+	{
+		// The value an entity is filed under, and its place amongst the entities with that value
+		struct Entry
+		{
+			Key			m_key;
+			uint32_t	m_position;
+		};
+
+	public:
+		explicit HashIndex( Key T::* field ) : m_field( field )
+		{}
+
+		void Insert( EntityId entityId, const void* component ) override
+		{
+			const Key& key = static_cast<const T*>( component )->*m_field;
+
+			const auto entry = m_entries.find( entityId );
+			if( entry != m_entries.end() )
+			{
+				if( entry->second.m_key == key )	// Already filed under this value
+				{
+					return;
+				}
+
+				RemoveFromBucket( entityId, entry->second );
+				entry->second.m_key = key;
+				entry->second.m_position = AddToBucket( entityId, key );
+				return;
+			}
+
+			const uint32_t position = AddToBucket( entityId, key );
+			m_entries.emplace( entityId, Entry{ key, position } );
+		}
+
+		void Erase( EntityId entityId ) override
+		{
+			const auto entry = m_entries.find( entityId );
+			if( entry == m_entries.end() )
+			{
+				return;
+			}
+
+			RemoveFromBucket( entityId, entry->second );
+			m_entries.erase( entry );
+		}
+
+		inline size_t GetSize() const override { return m_entries.size(); }
+
+		/*
+		*	@return	vector<EntityId>:	The entities filed under the passed value, in no particular order
+		*								The reference is valid until the next change to this index
+		*/
+		const std::vector<EntityId>& Find( const Key& key ) const
+		{
+			static const std::vector<EntityId> none;
+
+			const auto bucket = m_buckets.find( key );
+			return bucket != m_buckets.end() ? bucket->second : none;
+		}
+
+		// The number of entities filed under the passed value
+		inline size_t Count( const Key& key ) const { return Find( key ).size(); }
+
+	private:
+		uint32_t AddToBucket( EntityId entityId, const Key& key )
+		{
+			std::vector<EntityId>& bucket = m_buckets[key];
+			bucket.push_back( entityId );
+			return static_cast<uint32_t>( bucket.size() - 1 );
+		}
+
+		// The last entity of the bucket takes the place of the removed entity
+		void RemoveFromBucket( EntityId entityId, const Entry& entry )
+		{
+			const auto bucket = m_buckets.find( entry.m_key );
+			std::vector<EntityId>& entities = bucket->second;
+
+			const EntityId lastEntityId = entities.back();
+			entities[entry.m_position] = lastEntityId;
+			entities.pop_back();
+
+			if( lastEntityId != entityId )
+			{
+				m_entries.find( lastEntityId )->second.m_position = entry.m_position;
+			}
+
+			if( entities.empty() )
+			{
+				m_buckets.erase( bucket );
+			}
+		}
+
+		Key T::*										m_field;
+
+		// The entities filed under each value
+		std::unordered_map<Key, std::vector<EntityId>, Hash>	m_buckets;
+
+		// Where each indexed entity is filed
+		std::unordered_map<EntityId, Entry>				m_entries;
+	};
+
+	/*
+	*	Keeps the entities sorted by the value of a field of their component <T>, finding a value or a range of values in logarithmic time
+	*	@param	<T>:		The component type
+	*	@param	<Key>:		The type of the indexed field, ordered by <Compare>
+	*/
+	template<typename T, typename Key, typename Compare = std::less<Key>>
+	class OrderedIndex : public IFieldIndex
+	{
+		using EntityMap = std::multimap<Key, EntityId, Compare>;
+
+	public:
+		explicit OrderedIndex( Key T::* field ) : m_field( field )
+		{}
+
+		void Insert( EntityId entityId, const void* component ) override
+		{
+			const Key& key = static_cast<const T*>( component )->*m_field;
+
+			const auto entry = m_entries.find( entityId );
+			if( entry != m_entries.end() )
+			{
+				const Key& currentKey = entry->second->first;
+				if( !m_compare( currentKey, key ) && !m_compare( key, currentKey ) )	// Already filed under this value
+				{
+					return;
+				}
+
+				m_entities.erase( entry->second );
+				entry->second = m_entities.emplace( key, entityId );
+				return;
+			}
+
+			m_entries.emplace( entityId, m_entities.emplace( key, entityId ) );
+		}
+
+		void Erase( EntityId entityId ) override
+		{
+			const auto entry = m_entries.find( entityId );
+			if( entry == m_entries.end() )
+			{
+				return;
+			}
+
+			m_entities.erase( entry->second );
+			m_entries.erase( entry );
+		}
+
+		inline size_t GetSize() const override { return m_entities.size(); }
+
+		/*
+		*	Appends the entities filed under the passed value
+		*	@return	size_t:		The number of entities appended
+		*/
+		size_t Find( const Key& key, std::vector<EntityId>& entities ) const
+		{
+			const auto range = m_entities.equal_range( key );
+			return Append( range.first, range.second, entities );
+		}
+
+		/*
+		*	Appends the entities filed under a value between the passed values, both included, in ascending order of their values
+		*	@return	size_t:		The number of entities appended
+		*/
+		size_t FindRange( const Key& min, const Key& max, std::vector<EntityId>& entities ) const
+		{
+			if( m_compare( max, min ) )
+			{
+				return 0;
+			}
+
+			return Append( m_entities.lower_bound( min ), m_entities.upper_bound( max ), entities );
+		}
+
+		// The number of entities filed under the passed value
+		inline size_t Count( const Key& key ) const { return m_entities.count( key ); }
+
+		/*
+		*	Calls the passed function with the value and EntityId of every entity, in ascending order of their values
+		*	The index must not change while it is being visited
+		*/
+		template<typename Function>
+		void ForEach( Function function ) const
+		{
+			for( const auto& entity : m_entities )
+			{
+				function( entity.first, entity.second );
+			}
+		}
+
+	private:
+		static size_t Append( typename EntityMap::const_iterator first, typename EntityMap::const_iterator last, std::vector<EntityId>& entities )
+		{
+			const size_t size = entities.size();
+			for( ; first != last; ++first )
+			{
+				entities.push_back( first->second );
+			}
+			return entities.size() - size;
+		}
+
+		Key T::*												m_field;
+
+		Compare													m_compare;
+
+		// Every indexed entity, sorted by its value
+		EntityMap												m_entities;
+
+		// Where each indexed entity is filed, multimap iterators stay valid until their element is erased
+		std::unordered_map<EntityId, typename EntityMap::iterator>	m_entries;
+	};
+}
+
+#endif // !NEBULA_FIELDINDEX_H
@@ -0,0 +1,125 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_IQUERYMEMBERSHIP_H
+#define NEBULA_IQUERYMEMBERSHIP_H
+
+#include "Constants.h"
+#include "Signature.h"
+#include "ISystem.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace Nebula
+{
+	struct Entity;
+
+	/*
+	*	The entities matching a query, shared by every system whose query has the same ComponentTuple and the same masks
+	*	The SystemManager keeps one membership per distinct query, and refreshes it once per structural change, however many systems share it
+	*/
+	class IQueryMembership
+	{
+		IQueryMembership( const IQueryMembership& ) = delete;
+		IQueryMembership( IQueryMembership&& ) = delete;
+		IQueryMembership& operator=( const IQueryMembership& ) = delete;
+		IQueryMembership& operator=( IQueryMembership&& ) = delete;
+
+		friend class SystemManager;
+
+		// The TypeIndex of the concrete membership type, which stands for its ComponentTuple
+		size_t					m_typeIndex;
+
+		// Mask of all the component and tag types a member must have
+		Signature				m_requiredMask;
+
+		// Mask of all the component and tag types a member must not have
+		Signature				m_excludedMask;
+
+		// Mask of the component types held by the ComponentTuple
+		Signature				m_tupleMask;
+
+		// The number of systems sharing this membership
+		size_t					m_systemCount;
+
+		// The reactive systems sharing this membership, told about every entity entering and leaving
+		std::vector<ISystem*>	m_observers;
+
+	public:
+		IQueryMembership( size_t typeIndex, const Signature& requiredMask, const Signature& excludedMask, const Signature& tupleMask ) :
+			m_typeIndex( typeIndex ),
+			m_requiredMask( requiredMask ),
+			m_excludedMask( excludedMask ),
+			m_tupleMask( tupleMask ),
+			m_systemCount( 0 ),
+			m_observers()
+		{}
+		virtual ~IQueryMembership() = default;
+
+		// Adds, refreshes or removes the passed entity, depending on whether its signature matches the query
+		virtual void OnEntitySignatureChanged( const Entity& entity ) = 0;
+
+		virtual void OnEntitiesSignatureChanged( const std::vector<Entity*>& entities ) = 0;
+
+		// Adds every existing entity matching the query, called once when the membership is created
+		virtual void MatchExistingEntities() = 0;
+
+		/*
+		*	Points the passed entity's ComponentTuple at the new place of its component, the entity's signature is unchanged
+		*	@param	EntityId:		The entity whose component was moved
+		*	@param	SignatureIndex:	The signature index of the moved component's type, which must be held by the ComponentTuple
+		*/
+		virtual void OnComponentRelocated( EntityId entityId, size_t signatureIndex ) = 0;
+
+		inline const Signature& GetRequiredMask() const { return m_requiredMask; }
+
+		inline const Signature& GetExcludedMask() const { return m_excludedMask; }
+
+		// The number of systems sharing this membership
+		inline size_t GetSystemCount() const { return m_systemCount; }
+
+		inline bool Matches( const Signature& signature ) const
+		{
+			return ( signature & m_requiredMask ) == m_requiredMask && ( signature & m_excludedMask ).none();
+		}
+
+		// Reactive systems only, the system is told about every entity entering and leaving from now on
+		void AddObserver( ISystem* system )
+		{
+			if( std::find( m_observers.begin(), m_observers.end(), system ) == m_observers.end() )
+			{
+				m_observers.push_back( system );
+			}
+		}
+
+		void RemoveObserver( ISystem* system )
+		{
+			m_observers.erase( std::remove( m_observers.begin(), m_observers.end(), system ), m_observers.end() );
+		}
+
+	protected:
+		inline void NotifyEntityAdded( EntityId entityId )
+		{
+			for( ISystem* observer : m_observers )
+			{
+				observer->OnEntityAdded( entityId );
+			}
+		}
+
+		inline void NotifyEntityRemoved( EntityId entityId )
+		{
+			for( ISystem* observer : m_observers )
+			{
+				observer->OnEntityRemoved( entityId );
+			}
+		}
+
+	private:
+		inline bool IsQuery( size_t typeIndex, const Signature& requiredMask, const Signature& excludedMask ) const
+		{
+			return m_typeIndex == typeIndex && m_requiredMask == requiredMask && m_excludedMask == excludedMask;
+		}
+	};
+}
+
+#endif // !NEBULA_IQUERYMEMBERSHIP_H
@@ -3,6 +3,13 @@
 #ifndef NEBULA_ISYSTEM_H
 #define NEBULA_ISYSTEM_H
 
+#include "Constants.h"
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
 namespace Nebula 
 {
 	class ISystem
@@ -13,6 +20,7 @@ namespace Nebula
 		ISystem& operator=(ISystem&&) = delete;
 
 		friend class SystemManager;
+		friend class IQueryMembership;
 
 		// Unique Identifier Managed by the SystemManager
 		uint64_t		m_systemManagerId;
@@ -23,18 +31,129 @@ namespace Nebula
 		// The world this system exists in
 		class World*			m_world;
 
+		// The component manager of the world this system exists in
+		class ComponentManager*	m_componentManager;
+
+		// The IDs of the world resources this system reads from and writes to
+		std::vector<uint64_t>	m_resourceReads;
+		std::vector<uint64_t>	m_resourceWrites;
+
+		// The minimum time in seconds between two updates of this system, 0 updates the system every time the world updates
+		float					m_updateInterval;
+
+		// Time accumulated since the last update of this system
+		float					m_timeSinceUpdate;
+
+		// Time accumulated since each slice of this system's entities was last updated, empty when time slicing is off
+		std::vector<float>		m_sliceTimes;
+
+		// The slice of this system's entities processed by the current update
+		uint32_t				m_currentSlice;
+
+		// The time taken by each update of this system, recorded by the SystemManager
+		LatencyHistogram		m_latencyHistogram;
+
+		// The time a single update of this system should take at most, 0 for no budget
+		uint64_t				m_latencyBudget;
+
+		// The number of updates that took longer than 'm_latencyBudget'
+		uint64_t				m_overBudgetCount;
+
 	public:
 
 		explicit ISystem(uint64_t systemID):
 			m_systemManagerId(0),
 			m_systemId(systemID),
-			m_world(nullptr)
+			m_world(nullptr),
+			m_componentManager(nullptr),
+			m_updateInterval(0.0f),
+			m_timeSinceUpdate(0.0f),
+			m_sliceTimes(),
+			m_currentSlice(0),
+			m_latencyHistogram(),
+			m_latencyBudget(0),
+			m_overBudgetCount(0)
 		{};
 		virtual ~ISystem() = default;
 
 		virtual void Update(float deltaTime) = 0;
 
-		virtual void OnEntitySignatureChanged( const struct Entity& entity ) = 0;
+		/*
+		*	Limits how often this system updates, i.e. 0.1f for 10 updates per second
+		*	The deltaTime passed to Update is the time accumulated since the previous update of this system
+		*	@param	Interval:	The minimum time in seconds between two updates, 0 updates the system every time the world updates
+		*/
+		void SetUpdateInterval( float interval )
+		{
+			m_updateInterval = interval > 0.0f ? interval : 0.0f;
+		}
+
+		inline float GetUpdateInterval() const { return m_updateInterval; }
+
+		/*
+		*	Spreads the entities of this system over several updates, each update processes a rotating 1/Slices of the entities
+		*	The deltaTime passed to Update is the time accumulated since the current slice was last processed
+		*	The current slice is honoured by System::ForEach and System::ForEachChunk
+		*	@param	Slices:		The number of updates it takes to process every entity once, 1 turns time slicing off
+		*/
+		void SetTimeSlices( uint32_t slices )
+		{
+			m_sliceTimes.assign( slices > 1 ? slices : 0, 0.0f );
+			// The first update processes slice 0
+			m_currentSlice = slices > 1 ? slices - 1 : 0;
+		}
+
+		inline uint32_t GetTimeSlices() const { return m_sliceTimes.empty() ? 1 : static_cast<uint32_t>( m_sliceTimes.size() ); }
+
+		inline uint32_t GetCurrentSlice() const { return m_currentSlice; }
+
+		/*
+		*	Sets the time a single update of this system should take at most, every slower update is reported, see SystemManager::SetBudgetExceededCallback
+		*	@param	Budget:		The budget in seconds, 0 for no budget
+		*/
+		void SetLatencyBudget( float budget )
+		{
+			m_latencyBudget = budget > 0.0f ? static_cast<uint64_t>( static_cast<double>( budget ) * 1e9 ) : 0;
+		}
+
+		// The budget in nanoseconds, 0 for no budget
+		inline uint64_t GetLatencyBudget() const { return m_latencyBudget; }
+
+		inline uint64_t GetOverBudgetCount() const { return m_overBudgetCount; }
+
+		// The time taken by each update of this system, in nanoseconds
+		inline const LatencyHistogram& GetLatencyHistogram() const { return m_latencyHistogram; }
+
+		inline uint64_t GetSystemId() const { return m_systemId; }
+
+		inline const std::vector<uint64_t>& GetResourceReads() const { return m_resourceReads; }
+
+		inline const std::vector<uint64_t>& GetResourceWrites() const { return m_resourceWrites; }
+
+		/*
+		*	Checks the declared resource access of this system against the passed system
+		*	@return	bool:	Returns true, if either system writes a resource the other system reads or writes, these systems cannot run concurrently
+		*/
+		bool HasResourceConflict( const ISystem& other ) const
+		{
+			for( const uint64_t resource : m_resourceWrites )
+			{
+				if( Contains( other.m_resourceWrites, resource ) || Contains( other.m_resourceReads, resource ) )
+				{
+					return true;
+				}
+			}
+
+			for( const uint64_t resource : m_resourceReads )
+			{
+				if( Contains( other.m_resourceWrites, resource ) )
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
 
 	protected:
 
@@ -43,6 +162,89 @@ namespace Nebula
 			return m_world;
 		};
 
+		inline ComponentManager* GetComponentManager() const
+		{
+			return m_componentManager;
+		};
+
+		// Declares that this system reads the world resource of type <T>
+		template<typename T>
+		void ReadsResource()
+		{
+			if( !Contains( m_resourceReads, T::ID ) )
+			{
+				m_resourceReads.push_back( T::ID );
+			}
+		}
+
+		// Declares that this system writes to the world resource of type <T>
+		template<typename T>
+		void WritesResource()
+		{
+			if( !Contains( m_resourceWrites, T::ID ) )
+			{
+				m_resourceWrites.push_back( T::ID );
+			}
+		}
+
+	private:
+
+		// Called by the SystemManager once the system knows its world and component manager, the system acquires its membership here
+		virtual void OnRegistered( class SystemManager& ) {}
+
+		// Called by the SystemManager right before the system is deleted, the system releases its membership here
+		virtual void OnUnregistered( class SystemManager& ) {}
+
+		// Reactive systems only, called by the system's membership when an entity entered or left its query
+		virtual void OnEntityAdded( EntityId ) {}
+		virtual void OnEntityRemoved( EntityId ) {}
+
+		// Called by the SystemManager right before each update of the system, with the entities whose membership changed since the last update
+		virtual void DispatchMembershipChanges() {}
+
+		/*
+		*	Accumulates the time passed since the last world update, and decides if this system updates now
+		*	@param	DeltaTime:			The time passed since the last world update
+		*	@param	UpdateDeltaTime:	Set to the deltaTime this system should update with
+		*	@return	bool:				Returns true, if the system should update
+		*/
+		bool AdvanceTime( float deltaTime, float& updateDeltaTime )
+		{
+			m_timeSinceUpdate += deltaTime;
+
+			if( m_timeSinceUpdate < m_updateInterval )
+			{
+				return false;
+			}
+
+			const float elapsedTime = m_timeSinceUpdate;
+			m_timeSinceUpdate = 0.0f;
+
+			if( m_sliceTimes.empty() )
+			{
+				updateDeltaTime = elapsedTime;
+				return true;
+			}
+
+			m_currentSlice = ( m_currentSlice + 1 ) % static_cast<uint32_t>( m_sliceTimes.size() );
+
+			// Every slice ages, only the slice processed now is reset
+			for( float& sliceTime : m_sliceTimes )
+			{
+				sliceTime += elapsedTime;
+			}
+
+			updateDeltaTime = m_sliceTimes[m_currentSlice];
+			m_sliceTimes[m_currentSlice] = 0.0f;
+
+			return true;
+		}
+
+		static bool Contains( const std::vector<uint64_t>& resources, uint64_t resource )
+		{
+			return std::find( resources.begin(), resources.end(), resource ) != resources.end();
+		}
+
 	};
 	
 }
@@ -0,0 +1,332 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_INGESTIONQUEUE_H
+#define NEBULA_INGESTIONQUEUE_H
+
+#include "Constants.h"
+#include "Component.h"
+#include "EntityManager.h"
+#include "ComponentManager.h"
+
+#include "../utility/Memory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Nebula
+{
+	// The counters of an ingestion queue, see IngestionQueue::GetStats
+	struct IngestionStats
+	{
+		// The number of records accepted by the queue
+		uint64_t	m_pushedCount;
+
+		// The number of records refused because the queue was full, the backpressure felt by the producer
+		uint64_t	m_rejectedCount;
+
+		// The number of records drained into the world, dropped records included
+		uint64_t	m_drainedCount;
+
+		// The number of drained records that could not be applied, i.e. updates of entities that do not exist, or spawns over the component limit
+		uint64_t	m_droppedCount;
+
+		// The number of records waiting to be drained
+		size_t		m_size;
+
+		// The most records that were waiting at once when the queue was drained
+		size_t		m_highWaterMark;
+
+		size_t		m_capacity;
+	};
+
+	/*
+	*	Type-erased ingestion queue, drained by the World at its sync point
+	*/
+	class IIngestionQueue
+	{
+	public:
+		IIngestionQueue() = default;
+		virtual ~IIngestionQueue() = default;
+
+		/*
+		*	Applies the waiting records to the world, in the order they were pushed, on the world's thread
+		*	@return	size_t:		The number of records drained
+		*/
+		virtual size_t Drain( EntityManager& entityManager, ComponentManager& componentManager ) = 0;
+
+		virtual IngestionStats GetStats() const = 0;
+
+	private:
+		IIngestionQueue( const IIngestionQueue& ) = delete;
+		IIngestionQueue& operator=( const IIngestionQueue& ) = delete;
+		IIngestionQueue( IIngestionQueue&& ) = delete;
+		IIngestionQueue& operator=( IIngestionQueue&& ) = delete;
+	};
+
+	/*
+	*	Streams entities into the world from a single producer thread, i.e. an importer, without ever blocking either side
+	*	Each record holds one value of every component type of the queue, and either spawns a new entity or sets the components of an existing one
+	*	Records wait in a bounded lock-free ring buffer, until the world drains them in one batch at its next sync point, see World::Maintain
+	*	A full queue refuses records rather than waiting, the producer decides whether to retry, and the refusals are counted
+	*	@param	<Components>:	The component types of every record
+	*/
+	template<typename ... Components>
+	class IngestionQueue : public IIngestionQueue
+	{
+		static_assert( sizeof...( Components ) > 0, "IngestionQueue requires at least one component type" );
+
+		// A single record, an EntityId of 0 spawns a new entity
+		struct Record
+		{
+			template<typename ... Args>
+			Record( EntityId entityId, Args&& ... components ) :
+				m_entityId( entityId ),
+				m_components( std::forward<Args>( components ) ... )
+			{}
+
+			EntityId					m_entityId;
+			std::tuple<Components ...>	m_components;
+		};
+
+		// Over-aligned component types are honoured, the slots are allocated with AlignedAlloc
+		using Slot = typename std::aligned_storage<sizeof( Record ), alignof( Record )>::type;
+
+	public:
+		/*
+		*	@param	Capacity:		The number of records the queue holds, rounded up to a power of two
+		*							A queue whose records could not be allocated has a capacity of 0, and refuses every record
+		*	@param	MaxDrainCount:	The most records applied by a single drain, 0 for every waiting record
+		*/
+		explicit IngestionQueue( size_t capacity, size_t maxDrainCount = 0 ) :
+			m_slots( static_cast<Slot*>( AlignedAlloc( RoundUpToPowerOfTwo( capacity ) * sizeof( Slot ), alignof( Slot ) ) ) ),
+			m_capacity( m_slots != nullptr ? RoundUpToPowerOfTwo( capacity ) : 0 ),
+			m_mask( m_capacity - 1 ),
+			m_maxDrainCount( maxDrainCount ),
+			m_head( 0 ),
+			m_drainedCount( 0 ),
+			m_droppedCount( 0 ),
+			m_highWaterMark( 0 ),
+			m_tail( 0 ),
+			m_cachedHead( 0 ),
+			m_pushedCount( 0 ),
+			m_rejectedCount( 0 )
+		{}
+
+		~IngestionQueue() override
+		{
+			// Records that were never drained are dropped
+			const size_t tail = m_tail.load( std::memory_order_acquire );
+			for( size_t head = m_head.load( std::memory_order_relaxed ); head != tail; ++head )
+			{
+				GetRecord( head )->~Record();
+			}
+
+			AlignedFree( m_slots );
+		}
+
+		/*
+		*	Producer thread only, queues a record spawning a new entity with the passed components
+		*	@return	bool:	Returns false, if the queue is full
+		*/
+		template<typename ... Args>
+		bool TrySpawn( Args&& ... components )
+		{
+			return TryPush( 0, std::forward<Args>( components ) ... );
+		}
+
+		/*
+		*	Producer thread only, queues a record setting the passed components on an existing entity, components it lacks are added
+		*	@return	bool:	Returns false, if the queue is full
+		*/
+		template<typename ... Args>
+		bool TryUpdate( EntityId entityId, Args&& ... components )
+		{
+			return entityId != 0 && TryPush( entityId, std::forward<Args>( components ) ... );
+		}
+
+		/*
+		*	Safe to call from any thread, the counters are read one by one and may be slightly apart
+		*/
+		IngestionStats GetStats() const override
+		{
+			IngestionStats stats;
+			stats.m_pushedCount = m_pushedCount.load( std::memory_order_relaxed );
+			stats.m_rejectedCount = m_rejectedCount.load( std::memory_order_relaxed );
+			stats.m_drainedCount = m_drainedCount.load( std::memory_order_relaxed );
+			stats.m_droppedCount = m_droppedCount.load( std::memory_order_relaxed );
+			const size_t head = m_head.load( std::memory_order_acquire );
+			stats.m_size = m_tail.load( std::memory_order_acquire ) - head;
+			stats.m_highWaterMark = m_highWaterMark.load( std::memory_order_relaxed );
+			stats.m_capacity = m_capacity;
+			return stats;
+		}
+
+		/*
+		*	The EntityIds of the entities spawned by the last drain, in the order their records were pushed
+		*	Only valid on the world's thread, until the next drain
+		*/
+		inline const std::vector<EntityId>& GetSpawnedEntities() const { return m_spawnedEntities; }
+
+		size_t Drain( EntityManager& entityManager, ComponentManager& componentManager ) override
+		{
+			m_spawnedEntities.clear();
+
+			const size_t head = m_head.load( std::memory_order_relaxed );
+			const size_t tail = m_tail.load( std::memory_order_acquire );
+
+			size_t count = tail - head;
+			if( count > m_highWaterMark.load( std::memory_order_relaxed ) )
+			{
+				m_highWaterMark.store( count, std::memory_order_relaxed );
+			}
+			if( m_maxDrainCount > 0 )
+			{
+				count = std::min( count, m_maxDrainCount );
+			}
+
+			if( count == 0 )
+			{
+				return 0;
+			}
+
+			uint64_t droppedCount = 0;
+
+			componentManager.BeginBatch();
+			for( size_t i = head; i < head + count; ++i )
+			{
+				Record* record = GetRecord( i );
+
+				EntityId entityId = record->m_entityId;
+				const bool bSpawn = entityId == 0;
+				if( bSpawn )
+				{
+					entityId = entityManager.CreateEntity();
+				}
+
+				if( entityId == 0 || !Apply( componentManager, entityId, record->m_components, std::index_sequence_for<Components ...>() ) )
+				{
+					// A spawned entity holding only some of the record's components is destroyed, a record spawns all of its entity or nothing
+					if( bSpawn && entityId != 0 )
+					{
+						componentManager.MarkComponentsForCleanUp( entityId );
+						entityManager.MarkEntityForCleanUp( entityId );
+					}
+					++droppedCount;
+				}
+				else if( bSpawn )
+				{
+					m_spawnedEntities.push_back( entityId );
+				}
+
+				record->~Record();
+			}
+			componentManager.EndBatch();
+
+			// Hands the slots back to the producer
+			m_head.store( head + count, std::memory_order_release );
+
+			m_drainedCount.fetch_add( count, std::memory_order_relaxed );
+			m_droppedCount.fetch_add( droppedCount, std::memory_order_relaxed );
+
+			return count;
+		}
+
+	private:
+		template<typename ... Args>
+		bool TryPush( EntityId entityId, Args&& ... components )
+		{
+			const size_t tail = m_tail.load( std::memory_order_relaxed );
+
+			// The consumer's position is only read again once the queue looks full
+			if( tail - m_cachedHead == m_capacity )
+			{
+				m_cachedHead = m_head.load( std::memory_order_acquire );
+				if( tail - m_cachedHead == m_capacity )
+				{
+					m_rejectedCount.fetch_add( 1, std::memory_order_relaxed );
+					return false;
+				}
+			}
+
+			new( &m_slots[tail & m_mask] ) Record( entityId, std::forward<Args>( components ) ... );
+
+			// Publishes the record to the consumer
+			m_tail.store( tail + 1, std::memory_order_release );
+
+			m_pushedCount.fetch_add( 1, std::memory_order_relaxed );
+
+			return true;
+		}
+
+		inline Record* GetRecord( size_t position )
+		{
+			return reinterpret_cast<Record*>( &m_slots[position & m_mask] );
+		}
+
+		// Sets every component of the record on the entity, returns false if any of them could not be set
+		template<size_t ... INDICES>
+		static bool Apply( ComponentManager& componentManager, EntityId entityId, std::tuple<Components ...>& components, std::index_sequence<INDICES ...> )
+		{
+			const bool bSet[] = { componentManager.SetComponent<Components>( entityId, std::move( std::get<INDICES>( components ) ) ) != nullptr ... };
+			return std::all_of( std::begin( bSet ), std::end( bSet ), []( bool b ) { return b; } );
+		}
+
+		static size_t RoundUpToPowerOfTwo( size_t capacity )
+		{
+			size_t size = 1;
+			while( size < capacity )
+			{
+				size <<= 1;
+			}
+			return size;
+		}
+
+		// Keeps the positions written by the producer and by the consumer on separate cache lines
+		static constexpr size_t CACHE_LINE_SIZE = 64;
+
+		Slot* const				m_slots;
+
+		// The number of slots, a power of two
+		const size_t			m_capacity;
+
+		const size_t			m_mask;
+
+		const size_t			m_maxDrainCount;
+
+		char					m_padding0[CACHE_LINE_SIZE];
+
+		// Consumer side, the position of the next record to drain
+		std::atomic<size_t>		m_head;
+
+		std::atomic<uint64_t>	m_drainedCount;
+		std::atomic<uint64_t>	m_droppedCount;
+		std::atomic<size_t>		m_highWaterMark;
+
+		// The entities spawned by the last drain
+		std::vector<EntityId>	m_spawnedEntities;
+
+		char					m_padding1[CACHE_LINE_SIZE];
+
+		// Producer side, the position of the next record to push
+		std::atomic<size_t>		m_tail;
+
+		// The consumer's position as of the last time the producer looked
+		size_t					m_cachedHead;
+
+		std::atomic<uint64_t>	m_pushedCount;
+		std::atomic<uint64_t>	m_rejectedCount;
+
+		char					m_padding2[CACHE_LINE_SIZE];
+	};
+
+	template<typename ... Components>
+	constexpr size_t IngestionQueue<Components ...>::CACHE_LINE_SIZE;
+}
+
+#endif // !NEBULA_INGESTIONQUEUE_H
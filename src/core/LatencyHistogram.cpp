@@ -0,0 +1,135 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Nebula
+{
+	constexpr uint32_t LatencyHistogram::SUB_BUCKET_BITS;
+	constexpr uint64_t LatencyHistogram::SUB_BUCKET_COUNT;
+	constexpr uint32_t LatencyHistogram::MAX_EXPONENT;
+	constexpr size_t LatencyHistogram::BUCKET_COUNT;
+
+	LatencyHistogram::LatencyHistogram() :
+		m_buckets(),
+		m_count( 0 ),
+		m_min( 0 ),
+		m_max( 0 ),
+		m_sum( 0 )
+	{}
+
+	void LatencyHistogram::Record( uint64_t nanoseconds )
+	{
+		if( m_buckets.empty() )
+		{
+			m_buckets.assign( BUCKET_COUNT, 0 );
+		}
+
+		++m_buckets[GetBucketIndex( nanoseconds )];
+
+		m_min = m_count == 0 ? nanoseconds : std::min( m_min, nanoseconds );
+		m_max = std::max( m_max, nanoseconds );
+		m_sum += nanoseconds;
+		++m_count;
+	}
+
+	void LatencyHistogram::Reset()
+	{
+		std::fill( m_buckets.begin(), m_buckets.end(), 0 );
+		m_count = 0;
+		m_min = 0;
+		m_max = 0;
+		m_sum = 0;
+	}
+
+	uint64_t LatencyHistogram::GetValueAtPercentile( double percentile ) const
+	{
+		if( m_count == 0 )
+		{
+			return 0;
+		}
+
+		// The number of recorded latencies at or below the requested one, at least 1
+		const double fraction = std::min( std::max( percentile, 0.0 ), 100.0 ) / 100.0;
+		const uint64_t target = std::max<uint64_t>( static_cast<uint64_t>( std::ceil( fraction * static_cast<double>( m_count ) ) ), 1 );
+
+		uint64_t count = 0;
+		for( size_t index = 0; index < m_buckets.size(); ++index )
+		{
+			count += m_buckets[index];
+			if( count >= target )
+			{
+				// The last bucket also counts every latency beyond it
+				return index == BUCKET_COUNT - 1 ? m_max : std::min( GetBucketMax( index ), m_max );
+			}
+		}
+
+		return m_max;
+	}
+
+	void LatencyHistogram::FillSnapshot( LatencySnapshot& snapshot ) const
+	{
+		snapshot.m_count = m_count;
+		snapshot.m_minNanoseconds = GetMin();
+		snapshot.m_maxNanoseconds = m_max;
+		snapshot.m_meanNanoseconds = GetMean();
+		snapshot.m_p50Nanoseconds = GetValueAtPercentile( 50.0 );
+		snapshot.m_p90Nanoseconds = GetValueAtPercentile( 90.0 );
+		snapshot.m_p99Nanoseconds = GetValueAtPercentile( 99.0 );
+		snapshot.m_p999Nanoseconds = GetValueAtPercentile( 99.9 );
+
+		snapshot.m_buckets.clear();
+		for( size_t index = 0; index < m_buckets.size(); ++index )
+		{
+			if( m_buckets[index] != 0 )
+			{
+				snapshot.m_buckets.emplace_back( GetBucketMax( index ), m_buckets[index] );
+			}
+		}
+	}
+
+	size_t LatencyHistogram::GetBucketIndex( uint64_t nanoseconds )
+	{
+		// Counted exactly
+		if( nanoseconds < 2 * SUB_BUCKET_COUNT )
+		{
+			return static_cast<size_t>( nanoseconds );
+		}
+
+		// The position of the highest set bit, found by halving the search range
+		uint32_t exponent = 0;
+		for( uint32_t shift = 32; shift > 0; shift >>= 1 )
+		{
+			if( exponent + shift < 64 && ( nanoseconds >> ( exponent + shift ) ) != 0 )
+			{
+				exponent += shift;
+			}
+		}
+
+		if( exponent > MAX_EXPONENT )
+		{
+			return BUCKET_COUNT - 1;
+		}
+
+		// The bits right below the highest one pick the bucket inside of its power of two
+		const uint64_t subBucket = ( nanoseconds >> ( exponent - SUB_BUCKET_BITS ) ) - SUB_BUCKET_COUNT;
+		return static_cast<size_t>( 2 * SUB_BUCKET_COUNT + ( exponent - SUB_BUCKET_BITS - 1 ) * SUB_BUCKET_COUNT + subBucket );
+	}
+
+	uint64_t LatencyHistogram::GetBucketMax( size_t index )
+	{
+		if( index < 2 * SUB_BUCKET_COUNT )
+		{
+			return index;
+		}
+
+		const size_t offset = index - 2 * SUB_BUCKET_COUNT;
+		const uint32_t exponent = static_cast<uint32_t>( SUB_BUCKET_BITS + 1 + offset / SUB_BUCKET_COUNT );
+		const uint32_t shift = exponent - SUB_BUCKET_BITS;
+
+		const uint64_t bucketMin = ( SUB_BUCKET_COUNT + offset % SUB_BUCKET_COUNT ) << shift;
+		return bucketMin + ( uint64_t( 1 ) << shift ) - 1;
+	}
+}
@@ -0,0 +1,101 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_LATENCYHISTOGRAM_H
+#define NEBULA_LATENCYHISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Nebula
+{
+	// A copy of the latency histogram of a system, see SystemManager::GetLatencySnapshots
+	struct LatencySnapshot
+	{
+		// The 'ID' of the system
+		uint64_t	m_systemId;
+
+		// The number of recorded updates
+		uint64_t	m_count;
+
+		uint64_t	m_minNanoseconds;
+		uint64_t	m_maxNanoseconds;
+		double		m_meanNanoseconds;
+
+		uint64_t	m_p50Nanoseconds;
+		uint64_t	m_p90Nanoseconds;
+		uint64_t	m_p99Nanoseconds;
+		uint64_t	m_p999Nanoseconds;
+
+		// The budget of a single update, 0 if the system has none
+		uint64_t	m_budgetNanoseconds;
+
+		// The number of recorded updates that took longer than the budget
+		uint64_t	m_overBudgetCount;
+
+		// The buckets holding at least one update, as pairs of the highest latency of the bucket and its count, in increasing order of latency
+		std::vector< std::pair<uint64_t, uint64_t> >	m_buckets;
+	};
+
+	/*
+	*	Records latencies in nanoseconds into buckets of bounded relative error, in the manner of an HDR histogram
+	*	Latencies below 2 * SUB_BUCKET_COUNT are counted exactly, above that every power of two is split into SUB_BUCKET_COUNT buckets
+	*	A reported percentile is the highest latency of its bucket, at most 1 / SUB_BUCKET_COUNT above the recorded latency
+	*	The buckets are allocated by the first recorded latency, recording never allocates afterwards
+	*/
+	class LatencyHistogram
+	{
+	public:
+		// The number of buckets each power of two is split into
+		static constexpr uint32_t SUB_BUCKET_BITS = 6;
+		static constexpr uint64_t SUB_BUCKET_COUNT = uint64_t( 1 ) << SUB_BUCKET_BITS;
+
+		// Latencies of 2^(MAX_EXPONENT + 1) nanoseconds and more, about 2.4 hours, are counted in the last bucket
+		static constexpr uint32_t MAX_EXPONENT = 42;
+
+		static constexpr size_t BUCKET_COUNT = 2 * SUB_BUCKET_COUNT + ( MAX_EXPONENT - SUB_BUCKET_BITS ) * SUB_BUCKET_COUNT;
+
+		LatencyHistogram();
+
+		void Record( uint64_t nanoseconds );
+
+		// Drops every recorded latency, the buckets are kept
+		void Reset();
+
+		/*
+		*	@param	Percentile:		The percentile to find, from 0 to 100, i.e. 99.9
+		*	@return	uint64_t:		The latency in nanoseconds that the passed percentage of recorded latencies does not exceed, 0 if nothing was recorded
+		*/
+		uint64_t GetValueAtPercentile( double percentile ) const;
+
+		inline uint64_t GetCount() const { return m_count; }
+
+		inline uint64_t GetMin() const { return m_count > 0 ? m_min : 0; }
+
+		inline uint64_t GetMax() const { return m_max; }
+
+		inline double GetMean() const { return m_count > 0 ? static_cast<double>( m_sum ) / static_cast<double>( m_count ) : 0.0; }
+
+		/*
+		*	Fills in the counters, percentiles and buckets of the passed snapshot
+		*/
+		void FillSnapshot( LatencySnapshot& snapshot ) const;
+
+	private:
+		static size_t GetBucketIndex( uint64_t nanoseconds );
+
+		// The highest latency counted by the bucket at the passed index
+		static uint64_t GetBucketMax( size_t index );
+
+		// Empty until the first latency is recorded
+		std::vector<uint64_t>	m_buckets;
+
+		uint64_t				m_count;
+		uint64_t				m_min;
+		uint64_t				m_max;
+		uint64_t				m_sum;
+	};
+}
+
+#endif // !NEBULA_LATENCYHISTOGRAM_H
@@ -0,0 +1,221 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_QUERY_H
+#define NEBULA_QUERY_H
+
+#include "Entity.h"
+#include "Component.h"
+#include "Signature.h"
+#include "ComponentManager.h"
+
+#include "../utility/TemplateHelper.h"
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace Nebula
+{
+	// Query term, the entity must also have all of these component or tag types, they are not part of the ComponentTuple
+	template<typename ... Types>
+	struct With {};
+
+	// Query term, the entity must not have any of these component or tag types
+	template<typename ... Types>
+	struct Without {};
+
+	// Query term, the component is part of the ComponentTuple when the entity has it, otherwise it is nullptr
+	template<typename T>
+	struct Optional {};
+
+	// Query term, the system creates an owning group for its plain component types, see ComponentGroup
+	struct OwningGroup {};
+
+	// Query term, the system receives the entities that entered and left its query once per update, see System::OnEntitiesAdded
+	struct Reactive {};
+
+	/*
+	*	Describes how a single term of a query contributes to the ComponentTuple and to the signature masks
+	*	A plain component type is required and part of the ComponentTuple
+	*	Owned lists the component types an owning group of the query takes over
+	*/
+	template<typename Term>
+	struct QueryTerm
+	{
+		using Pointers = std::tuple< Term* >;
+
+		using Owned = std::tuple< Term >;
+
+		static void AddToMasks( Signature& required, Signature& )
+		{
+			SetSignatureBits<Term>( required );
+		}
+	};
+
+	template<typename ... Types>
+	struct QueryTerm< With<Types ...> >
+	{
+		using Pointers = std::tuple<>;
+
+		using Owned = std::tuple<>;
+
+		static void AddToMasks( Signature& required, Signature& )
+		{
+			SetSignatureBits<Types ...>( required );
+		}
+	};
+
+	template<typename ... Types>
+	struct QueryTerm< Without<Types ...> >
+	{
+		using Pointers = std::tuple<>;
+
+		using Owned = std::tuple<>;
+
+		static void AddToMasks( Signature&, Signature& excluded )
+		{
+			SetSignatureBits<Types ...>( excluded );
+		}
+	};
+
+	template<typename T>
+	struct QueryTerm< Optional<T> >
+	{
+		using Pointers = std::tuple< T* >;
+
+		using Owned = std::tuple<>;
+
+		static void AddToMasks( Signature&, Signature& )
+		{}
+	};
+
+	template<>
+	struct QueryTerm< OwningGroup >
+	{
+		using Pointers = std::tuple<>;
+
+		using Owned = std::tuple<>;
+
+		static void AddToMasks( Signature&, Signature& )
+		{}
+	};
+
+	template<>
+	struct QueryTerm< Reactive >
+	{
+		using Pointers = std::tuple<>;
+
+		using Owned = std::tuple<>;
+
+		static void AddToMasks( Signature&, Signature& )
+		{}
+	};
+
+	/*
+	*	A Query is the set of terms that an entity's signature is matched against
+	*	i.e. Query<Position, Velocity, Optional<Mass>, Without<Frozen>>
+	*	Matching is performed on signature masks, the entity's components are only visited to fill the ComponentTuple of a matching entity
+	*/
+	template<typename ... Terms>
+	struct Query
+	{
+		// A pointer for each required and optional component, in the order they were declared
+		using ComponentTuple = decltype( std::tuple_cat( std::declval< typename QueryTerm<Terms>::Pointers >() ... ) );
+
+		// The plain component types of this query, in the order they were declared
+		using OwnedTuple = decltype( std::tuple_cat( std::declval< typename QueryTerm<Terms>::Owned >() ... ) );
+
+		// True if the query declares the OwningGroup term
+		static constexpr bool bOwningGroup = IsOneOf<OwningGroup, Terms ...>::value;
+
+		// True if the query declares the Reactive term
+		static constexpr bool bReactive = IsOneOf<Reactive, Terms ...>::value;
+
+		// Mask of all the component and tag types an entity must have to match this query
+		static const Signature& GetRequiredMask()
+		{
+			static const Signature mask = BuildMasks().first;
+			return mask;
+		}
+
+		// Mask of all the component and tag types an entity must not have to match this query
+		static const Signature& GetExcludedMask()
+		{
+			static const Signature mask = BuildMasks().second;
+			return mask;
+		}
+
+		static bool Matches( const Signature& signature )
+		{
+			const Signature& required = GetRequiredMask();
+			return ( signature & required ) == required && ( signature & GetExcludedMask() ).none();
+		}
+
+		/*
+		*	Fills the passed ComponentTuple with the components of the passed entity, optional components that are not on the entity are set to nullptr
+		*	@param	ComponentManager:	The component manager storing the entity's components
+		*	@param	EntityId:			The entity to take the components from
+		*	@param	ComponentTuple:		The tuple to fill
+		*/
+		static void Fill( const ComponentManager& componentManager, EntityId entityId, ComponentTuple& tupleToFill )
+		{
+			TupleFiller<ComponentTuple>::template FillElement<0>( componentManager, entityId, tupleToFill );
+		}
+
+	private:
+
+		static std::pair<Signature, Signature> BuildMasks()
+		{
+			std::pair<Signature, Signature> masks;
+			AddTermsToMasks<Terms ...>( masks.first, masks.second );
+
+			// Prefabs and hibernating entities are only matched by queries that ask for them
+			if( !masks.first.test( GetSignatureIndex<Prefab>() ) )
+			{
+				SetSignatureBits<Prefab>( masks.second );
+			}
+			if( !masks.first.test( GetSignatureIndex<Hibernating>() ) )
+			{
+				SetSignatureBits<Hibernating>( masks.second );
+			}
+
+			return masks;
+		}
+
+		template<typename Term, typename ... Rest>
+		static void AddTermsToMasks( Signature& required, Signature& excluded )
+		{
+			QueryTerm<Term>::AddToMasks( required, excluded );
+			AddTermsToMasks<Rest ...>( required, excluded );
+		}
+
+		template<typename ... Rest>
+		static typename std::enable_if< sizeof...( Rest ) == 0 >::type AddTermsToMasks( Signature&, Signature& )
+		{}
+
+		template<typename Tuple>
+		struct TupleFiller;
+
+		template<typename ... Components>
+		struct TupleFiller< std::tuple<Components* ...> >
+		{
+			// Looks up the component of each element of the tuple, one element per loop of recursion
+			template<size_t INDEX>
+			static typename std::enable_if< ( INDEX < sizeof...( Components ) ) >::type FillElement( const ComponentManager& componentManager, EntityId entityId, ComponentTuple& tupleToFill )
+			{
+				using ComponentClass = typename std::tuple_element< INDEX, std::tuple<Components ...> >::type;
+
+				std::get<INDEX>( tupleToFill ) = componentManager.FindComponent<ComponentClass>( entityId );
+
+				FillElement<INDEX + 1>( componentManager, entityId, tupleToFill );
+			}
+
+			// Recursion ender, all elements of the tuple are filled
+			template<size_t INDEX>
+			static typename std::enable_if< ( INDEX == sizeof...( Components ) ) >::type FillElement( const ComponentManager&, EntityId, ComponentTuple& )
+			{}
+		};
+	};
+}
+
+#endif // !NEBULA_QUERY_H
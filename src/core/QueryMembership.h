@@ -0,0 +1,187 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_QUERYMEMBERSHIP_H
+#define NEBULA_QUERYMEMBERSHIP_H
+
+#include "IQueryMembership.h"
+#include "Entity.h"
+#include "ComponentManager.h"
+
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Nebula
+{
+	template<typename Tuple>
+	class QueryMembership;
+
+	/*
+	*	The ComponentTuples of the entities matching a query, and their owning entities at the same index
+	*	@param	<Components>:	The component types of the ComponentTuple, see Query::ComponentTuple
+	*/
+	template<typename ... Components>
+	class QueryMembership< std::tuple<Components* ...> > : public IQueryMembership
+	{
+	public:
+		using ComponentTuple = std::tuple<Components* ...>;
+
+		// Sentinel for an entity that is not a member
+		static constexpr size_t INVALID_INDEX = static_cast<size_t>( -1 );
+
+		QueryMembership( ComponentManager* componentManager, size_t typeIndex, const Signature& requiredMask, const Signature& excludedMask ) :
+			IQueryMembership( typeIndex, requiredMask, excludedMask, GetTupleMask() ),
+			m_componentManager( componentManager ),
+			m_membershipVersion( 0 )
+		{}
+		virtual ~QueryMembership() override = default;
+
+		inline std::vector<ComponentTuple>& GetComponents() { return m_components; }
+
+		inline const std::vector<EntityId>& GetEntities() const { return m_entities; }
+
+		// Returns the index of the passed entity inside of GetComponents(), INVALID_INDEX if the entity is not a member
+		inline size_t GetIndex( EntityId entityId ) const
+		{
+			return entityId < m_entityIndices.size() ? m_entityIndices[entityId] : INVALID_INDEX;
+		}
+
+		// Incremented every time an entity is added or removed
+		inline uint64_t GetMembershipVersion() const { return m_membershipVersion; }
+
+		// Reserves room for all of the passed entities before matching them one by one
+		virtual void OnEntitiesSignatureChanged( const std::vector<Entity*>& entities ) override
+		{
+			const size_t capacity = m_components.size() + entities.size();
+			if( capacity > m_components.capacity() )
+			{
+				m_components.reserve( std::max( capacity, m_components.capacity() * 2 ) );
+				m_entities.reserve( std::max( capacity, m_entities.capacity() * 2 ) );
+			}
+
+			for( const Entity* entity : entities )
+			{
+				OnEntitySignatureChanged( *entity );
+			}
+		}
+
+		virtual void MatchExistingEntities() override
+		{
+			if( m_componentManager == nullptr )
+			{
+				return;
+			}
+
+			std::vector<Entity*> entities;
+			m_componentManager->GetLiveEntities( entities );
+			OnEntitiesSignatureChanged( entities );
+		}
+
+		// If the passed entity's signature matches the query, the entity's components are added or refreshed
+		// If not, then the entity's components are removed, if they were here
+		virtual void OnEntitySignatureChanged( const Entity& entity ) override
+		{
+			const EntityId entityId = entity.GetId();
+			const size_t index = GetIndex( entityId );
+
+			if( Matches( entity.GetSignature() ) )
+			{
+				const ComponentTuple componentTuple{ m_componentManager->FindComponent<Components>( entityId ) ... };
+
+				if( index != INVALID_INDEX )
+				{
+					m_components[index] = componentTuple;
+					return;
+				}
+
+				if( entityId >= m_entityIndices.size() )
+				{
+					m_entityIndices.resize( entityId + 1, INVALID_INDEX );
+				}
+
+				m_entityIndices[entityId] = m_components.size();
+				m_components.push_back( componentTuple );
+				m_entities.push_back( entityId );
+				++m_membershipVersion;
+
+				NotifyEntityAdded( entityId );
+			}
+			else if( index != INVALID_INDEX )
+			{
+				// Replace the entity's components with the last tuple
+				const size_t lastIndex = m_components.size() - 1;
+
+				m_components[index] = m_components[lastIndex];
+				m_entities[index] = m_entities[lastIndex];
+				m_entityIndices[m_entities[index]] = index;
+
+				m_components.pop_back();
+				m_entities.pop_back();
+				m_entityIndices[entityId] = INVALID_INDEX;
+				++m_membershipVersion;
+
+				NotifyEntityRemoved( entityId );
+			}
+		}
+
+		virtual void OnComponentRelocated( EntityId entityId, size_t signatureIndex ) override
+		{
+			const size_t index = GetIndex( entityId );
+			if( index != INVALID_INDEX )
+			{
+				RefreshComponent( m_components[index], entityId, signatureIndex, std::index_sequence_for<Components ...>() );
+			}
+		}
+
+	private:
+		static Signature GetTupleMask()
+		{
+			Signature mask;
+			SetSignatureBits<Components ...>( mask );
+			return mask;
+		}
+
+		// Finds the component of every type of the tuple that has the passed signature index again
+		template<size_t ... INDICES>
+		void RefreshComponent( ComponentTuple& componentTuple, EntityId entityId, size_t signatureIndex, std::index_sequence<INDICES ...> )
+		{
+			const int expansion[] = { 0, ( RefreshElement<INDICES>( componentTuple, entityId, signatureIndex ), 0 ) ... };
+			static_cast<void>( expansion );
+
+			// Unused when the query has no component types
+			static_cast<void>( componentTuple );
+			static_cast<void>( entityId );
+			static_cast<void>( signatureIndex );
+		}
+
+		template<size_t INDEX>
+		void RefreshElement( ComponentTuple& componentTuple, EntityId entityId, size_t signatureIndex )
+		{
+			using T = typename std::remove_pointer< typename std::tuple_element<INDEX, ComponentTuple>::type >::type;
+			if( GetSignatureIndex<T>() == signatureIndex )
+			{
+				std::get<INDEX>( componentTuple ) = m_componentManager->FindComponent<T>( entityId );
+			}
+		}
+
+		ComponentManager*				m_componentManager;
+
+		// The list of Component Tuples, where each tuple is a set of components owned by the same entity
+		std::vector<ComponentTuple>		m_components;
+
+		// The owning entity of each Component Tuple
+		std::vector<EntityId>			m_entities;
+
+		// Index of each entity's Component Tuple, indexed by EntityId
+		std::vector<size_t>				m_entityIndices;
+
+		uint64_t						m_membershipVersion;
+	};
+
+	template<typename ... Components>
+	constexpr size_t QueryMembership< std::tuple<Components* ...> >::INVALID_INDEX;
+}
+
+#endif // !NEBULA_QUERYMEMBERSHIP_H
@@ -0,0 +1,201 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_REFLECTION_H
+#define NEBULA_REFLECTION_H
+
+#include "Constants.h"
+
+#include "../utility/CompilerHash.h"
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace Nebula
+{
+	// Describes a single member of a component, see NEBULA_REFLECT
+	struct FieldDescriptor
+	{
+		const char*	m_name;
+
+		// The place of the member, in bytes from the start of the component
+		size_t		m_offset;
+
+		size_t		m_size;
+
+		size_t		m_alignment;
+
+		// Returns true, if the member can be copied byte by byte
+		bool		m_bTriviallyCopyable;
+	};
+
+	// Describes the layout of a component type, known at compile time, see ComponentReflection
+	struct ComponentDescriptor
+	{
+		// The name passed to NEBULA_REFLECT, nullptr for component types without reflected fields
+		const char*				m_name;
+
+		// The 'ID' of the component type, 0 for plain components without one
+		uint64_t				m_id;
+
+		size_t					m_size;
+
+		size_t					m_alignment;
+
+		// Returns true, if whole components can be copied byte by byte
+		bool					m_bTriviallyCopyable;
+
+		// The reflected members, in the order they were listed
+		const FieldDescriptor*	m_fields;
+		size_t					m_fieldCount;
+	};
+
+	// Detects the fields listed with NEBULA_REFLECT
+	template<typename T, typename = void>
+	struct HasReflectedFields : std::false_type {};
+
+	template<typename T>
+	struct HasReflectedFields<T, decltype( void( &T::GetReflectedFields ) )> : std::true_type {};
+
+	// Detects the 'ID' of a component type, 0 for types without one
+	template<typename T, typename = void>
+	struct ReflectedId : std::integral_constant<uint64_t, 0> {};
+
+	template<typename T>
+	struct ReflectedId<T, decltype( void( T::ID ) )> : std::integral_constant<uint64_t, T::ID> {};
+
+	/*
+	*	Compile-time layout of the component type <T>
+	*	Size, alignment and whether the type is trivially copyable are known for every type
+	*	The fields are known once the type lists them with NEBULA_REFLECT, next to its ID
+	*	@param	<T>:	The component type
+	*/
+	template<typename T>
+	struct ComponentReflection
+	{
+		static constexpr size_t SIZE = sizeof( T );
+
+		static constexpr size_t ALIGNMENT = alignof( T );
+
+		static constexpr bool bTriviallyCopyable = std::is_trivially_copyable<T>::value;
+
+		// Returns true, if the type lists its fields with NEBULA_REFLECT
+		static constexpr bool bReflected = HasReflectedFields<T>::value;
+
+		static constexpr uint64_t ID = ReflectedId<T>::value;
+
+		static const ComponentDescriptor& GetDescriptor()
+		{
+			static const ComponentDescriptor descriptor = MakeDescriptor( HasReflectedFields<T>() );
+			return descriptor;
+		}
+
+		/*
+		*	Identifies the type the same way on every run of the same program, unlike its signature index which follows the order types are first used in
+		*	The key is the 'ID' of the type, or a hash of the name the compiler gives the type for types without one
+		*	Hashed names only agree between builds of the same compiler, peers built with different compilers must give their component types an ID
+		*/
+		static uint64_t GetTypeKey()
+		{
+			static const uint64_t key = ID != 0 ? ID : HashTypeName();
+			return key;
+		}
+
+	private:
+		// Kept above the 32 bits of an 'ID', a hashed name never equals one
+		static uint64_t HashTypeName()
+		{
+#if defined( _MSC_VER )
+			const char* name = __FUNCSIG__;
+#else
+			const char* name = __PRETTY_FUNCTION__;
+#endif
+			return ( uint64_t( 1 ) << 32 ) | ( crc32_update( name, std::strlen( name ) ) ^ 0xFFFFFFFF );
+		}
+
+		static ComponentDescriptor MakeDescriptor( std::true_type )
+		{
+			size_t fieldCount = 0;
+			const FieldDescriptor* fields = T::GetReflectedFields( fieldCount );
+			return ComponentDescriptor{ T::GetReflectedName(), ID, SIZE, ALIGNMENT, bTriviallyCopyable, fields, fieldCount };
+		}
+
+		static ComponentDescriptor MakeDescriptor( std::false_type )
+		{
+			return ComponentDescriptor{ nullptr, ID, SIZE, ALIGNMENT, bTriviallyCopyable, nullptr, 0 };
+		}
+	};
+
+	template<typename T>
+	constexpr size_t ComponentReflection<T>::SIZE;
+
+	template<typename T>
+	constexpr size_t ComponentReflection<T>::ALIGNMENT;
+
+	template<typename T>
+	constexpr bool ComponentReflection<T>::bTriviallyCopyable;
+
+	template<typename T>
+	constexpr bool ComponentReflection<T>::bReflected;
+
+	template<typename T>
+	constexpr uint64_t ComponentReflection<T>::ID;
+}
+
+// offsetof is only conditionally supported for types that are not standard layout, such as those deriving from Component
+// Every supported compiler computes it for single, non-virtual inheritance
+#if defined( __GNUC__ )
+#define NEBULA_REFLECT_BEGIN_OFFSETS _Pragma( "GCC diagnostic push" ) _Pragma( "GCC diagnostic ignored \"-Winvalid-offsetof\"" )
+#define NEBULA_REFLECT_END_OFFSETS _Pragma( "GCC diagnostic pop" )
+#else
+#define NEBULA_REFLECT_BEGIN_OFFSETS
+#define NEBULA_REFLECT_END_OFFSETS
+#endif
+
+#define NEBULA_REFLECT_EXPAND( x ) x
+
+#define NEBULA_REFLECT_FIELD( Type, Field ) \
+	::Nebula::FieldDescriptor{ #Field, offsetof( Type, Field ), sizeof( decltype( Type::Field ) ), alignof( decltype( Type::Field ) ), std::is_trivially_copyable<decltype( Type::Field )>::value }
+
+#define NEBULA_REFLECT_FIELDS_1( Type, Field ) NEBULA_REFLECT_FIELD( Type, Field )
+#define NEBULA_REFLECT_FIELDS_2( Type, Field, ... ) NEBULA_REFLECT_FIELD( Type, Field ), NEBULA_REFLECT_EXPAND( NEBULA_REFLECT_FIELDS_1( Type, __VA_ARGS__ ) )
+#define NEBULA_REFLECT_FIELDS_3( Type, Field, ... ) NEBULA_REFLECT_FIELD( Type, Field ), NEBULA_REFLECT_EXPAND( NEBULA_REFLECT_FIELDS_2( Type, __VA_ARGS__ ) )
+#define NEBULA_REFLECT_FIELDS_4( Type, Field, ... ) NEBULA_REFLECT_FIELD( Type, Field ), NEBULA_REFLECT_EXPAND( NEBULA_REFLECT_FIELDS_3( Type, __VA_ARGS__ ) )
+#define NEBULA_REFLECT_FIELDS_5( Type, Field, ... ) NEBULA_REFLECT_FIELD( Type, Field ), NEBULA_REFLECT_EXPAND( NEBULA_REFLECT_FIELDS_4( Type, __VA_ARGS__ ) )
+#define NEBULA_REFLECT_FIELDS_6( Type, Field, ... ) NEBULA_REFLECT_FIELD( Type, Field ), NEBULA_REFLECT_EXPAND( NEBULA_REFLECT_FIELDS_5( Type, __VA_ARGS__ ) )
+#define NEBULA_REFLECT_FIELDS_7( Type, Field, ... ) NEBULA_REFLECT_FIELD( Type, Field ), NEBULA_REFLECT_EXPAND( NEBULA_REFLECT_FIELDS_6( Type, __VA_ARGS__ ) )
+#define NEBULA_REFLECT_FIELDS_8( Type, Field, ... ) NEBULA_REFLECT_FIELD( Type, Field ), NEBULA_REFLECT_EXPAND( NEBULA_REFLECT_FIELDS_7( Type, __VA_ARGS__ ) )
+#define NEBULA_REFLECT_FIELDS_9( Type, Field, ... ) NEBULA_REFLECT_FIELD( Type, Field ), NEBULA_REFLECT_EXPAND( NEBULA_REFLECT_FIELDS_8( Type, __VA_ARGS__ ) )
+#define NEBULA_REFLECT_FIELDS_10( Type, Field, ... ) NEBULA_REFLECT_FIELD( Type, Field ), NEBULA_REFLECT_EXPAND( NEBULA_REFLECT_FIELDS_9( Type, __VA_ARGS__ ) )
+#define NEBULA_REFLECT_FIELDS_11( Type, Field, ... ) NEBULA_REFLECT_FIELD( Type, Field ), NEBULA_REFLECT_EXPAND( NEBULA_REFLECT_FIELDS_10( Type, __VA_ARGS__ ) )
+#define NEBULA_REFLECT_FIELDS_12( Type, Field, ... ) NEBULA_REFLECT_FIELD( Type, Field ), NEBULA_REFLECT_EXPAND( NEBULA_REFLECT_FIELDS_11( Type, __VA_ARGS__ ) )
+#define NEBULA_REFLECT_FIELDS_13( Type, Field, ... ) NEBULA_REFLECT_FIELD( Type, Field ), NEBULA_REFLECT_EXPAND( NEBULA_REFLECT_FIELDS_12( Type, __VA_ARGS__ ) )
+#define NEBULA_REFLECT_FIELDS_14( Type, Field, ... ) NEBULA_REFLECT_FIELD( Type, Field ), NEBULA_REFLECT_EXPAND( NEBULA_REFLECT_FIELDS_13( Type, __VA_ARGS__ ) )
+#define NEBULA_REFLECT_FIELDS_15( Type, Field, ... ) NEBULA_REFLECT_FIELD( Type, Field ), NEBULA_REFLECT_EXPAND( NEBULA_REFLECT_FIELDS_14( Type, __VA_ARGS__ ) )
+#define NEBULA_REFLECT_FIELDS_16( Type, Field, ... ) NEBULA_REFLECT_FIELD( Type, Field ), NEBULA_REFLECT_EXPAND( NEBULA_REFLECT_FIELDS_15( Type, __VA_ARGS__ ) )
+
+#define NEBULA_REFLECT_SELECT( _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, NAME, ... ) NAME
+
+#define NEBULA_REFLECT_FIELDS( Type, ... ) NEBULA_REFLECT_EXPAND( NEBULA_REFLECT_SELECT( __VA_ARGS__, \
+	NEBULA_REFLECT_FIELDS_16, NEBULA_REFLECT_FIELDS_15, NEBULA_REFLECT_FIELDS_14, NEBULA_REFLECT_FIELDS_13, \
+	NEBULA_REFLECT_FIELDS_12, NEBULA_REFLECT_FIELDS_11, NEBULA_REFLECT_FIELDS_10, NEBULA_REFLECT_FIELDS_9, \
+	NEBULA_REFLECT_FIELDS_8, NEBULA_REFLECT_FIELDS_7, NEBULA_REFLECT_FIELDS_6, NEBULA_REFLECT_FIELDS_5, \
+	NEBULA_REFLECT_FIELDS_4, NEBULA_REFLECT_FIELDS_3, NEBULA_REFLECT_FIELDS_2, NEBULA_REFLECT_FIELDS_1 )( Type, __VA_ARGS__ ) )
+
+/*
+*	Lists the fields of a component type for ComponentReflection, placed inside of the type next to its ID, up to 16 fields
+*	i.e. NEBULA_REFLECT( HealthComponent, m_health, m_maxHealth )
+*	Unlisted members are left out of field by field handling, such as checksums
+*/
+#define NEBULA_REFLECT( Type, ... ) \
+	static constexpr const char* GetReflectedName() { return #Type; } \
+	static const ::Nebula::FieldDescriptor* GetReflectedFields( size_t& count ) \
+	{ \
+		NEBULA_REFLECT_BEGIN_OFFSETS \
+		static constexpr ::Nebula::FieldDescriptor fields[] = { NEBULA_REFLECT_FIELDS( Type, __VA_ARGS__ ) }; \
+		NEBULA_REFLECT_END_OFFSETS \
+		count = sizeof( fields ) / sizeof( fields[0] ); \
+		return fields; \
+	}
+
+#endif // !NEBULA_REFLECTION_H
@@ -0,0 +1,133 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_RESOURCEMANAGER_H
+#define NEBULA_RESOURCEMANAGER_H
+
+#include "../utility/TypeIndex.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Nebula
+{
+	/*
+	*	The Resource Manager owns the world-level singletons, i.e. time, input or configuration data
+	*	Exactly one instance of each resource type can exist per World
+	*	Resources are looked up through the dense index of their type, no searching or casting is performed
+	*
+	*	All user-defined Resources must contain the following static member:
+	*	static constexpr uint32_t ID = GENERATE_ID( "ExampleResourceName" );
+	*/
+	class ResourceManager
+	{
+		struct IResourceHolder
+		{
+			explicit IResourceHolder( uint64_t resourceType ) : m_resourceType( resourceType ) {}
+			virtual ~IResourceHolder() = default;
+
+			// This resource's unique type identifier
+			uint64_t m_resourceType;
+		};
+
+		template<typename T>
+		struct ResourceHolder : public IResourceHolder
+		{
+			template<typename ... Args>
+			explicit ResourceHolder( Args&& ... args ) :
+				IResourceHolder( T::ID ),
+				m_resource( std::forward<Args>( args ) ... )
+			{}
+
+			T m_resource;
+		};
+
+		// All resources on this manager, indexed by the TypeIndex of the resource type
+		std::vector<IResourceHolder*> m_resources;
+
+	public:
+		ResourceManager() = default;
+
+		~ResourceManager()
+		{
+			for( auto* r : m_resources )
+			{
+				delete r;
+			}
+			m_resources.clear();
+		}
+
+		/*
+		*	Creates the resource of type <T>, returning the created resource
+		*	@param	<T>:	The type of resource that will be created
+		*	@param	Args:	The constructor requirements for the resource
+		*	@return	T*:		The created resource, returns nullptr if a resource of type <T> already exists
+		*/
+		template<typename T, typename ... Args>
+		T* AddResource( Args&& ... args )
+		{
+			const size_t index = GetResourceIndex<T>();
+			if( index >= m_resources.size() )
+			{
+				m_resources.resize( index + 1, nullptr );
+			}
+
+			if( m_resources[index] != nullptr )	// Resource already exists
+			{
+				return nullptr;
+			}
+
+			ResourceHolder<T>* holder = new ResourceHolder<T>( std::forward<Args>( args ) ... );
+			m_resources[index] = holder;
+
+			return &holder->m_resource;
+		}
+
+		/*
+		*	@brief	Finds the resource of the passed type
+		*	@param	<T>		The type of resource to look for
+		*	@return	T*		Returns the resource if it exists, returning nullptr, if otherwise
+		*/
+		template<typename T>
+		T* GetResource()
+		{
+			const size_t index = GetResourceIndex<T>();
+			if( index >= m_resources.size() || m_resources[index] == nullptr )
+			{
+				return nullptr;
+			}
+
+			return &static_cast< ResourceHolder<T>* >( m_resources[index] )->m_resource;
+		}
+
+		/*
+		*	Destroys the resource of the passed type, if it exists
+		*	@param	<T>:	The type of resource to destroy
+		*/
+		template<typename T>
+		void RemoveResource()
+		{
+			const size_t index = GetResourceIndex<T>();
+			if( index >= m_resources.size() )
+			{
+				return;
+			}
+
+			delete m_resources[index], m_resources[index] = nullptr;
+		}
+
+	private:
+		ResourceManager( const ResourceManager& ) = delete;
+		ResourceManager& operator=( const ResourceManager& ) = delete;
+		ResourceManager( ResourceManager&& ) = delete;
+		ResourceManager& operator=( ResourceManager&& ) = delete;
+
+		template<typename T>
+		static size_t GetResourceIndex()
+		{
+			return TypeIndex<ResourceManager>::Get<T>();
+		}
+	};
+}
+
+#endif // !NEBULA_RESOURCEMANAGER_H
@@ -0,0 +1,312 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_SHAREDCOMPONENTSTORE_H
+#define NEBULA_SHAREDCOMPONENTSTORE_H
+
+#include "Constants.h"
+#include "ComponentPool.h"
+#include "FieldIndex.h"
+
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace Nebula
+{
+	template<typename T>
+	class SharedComponentStore;
+
+	/*
+	*	The component an entity holds for a shared value of type <T>, only the index of the value is stored per entity
+	*	Added and changed through ComponentManager::SetSharedComponent, queries can ask for it like any plain component, i.e. System<Position, Shared<Mesh>>
+	*/
+	template<typename T>
+	struct Shared
+	{
+		explicit Shared( uint32_t valueIndex ) : m_valueIndex( valueIndex ), m_position( IComponentPool::INVALID_INDEX ) {}
+
+		// The index of the value inside of its SharedComponentStore, the same for every entity sharing the value
+		inline uint32_t GetValueIndex() const { return m_valueIndex; }
+
+	private:
+		friend class SharedComponentStore<T>;
+
+		uint32_t	m_valueIndex;
+
+		// The place of the entity amongst the entities sharing the value
+		uint32_t	m_position;
+	};
+
+	// Only the index of the value is hashed, the place amongst the other entities sharing it is bookkeeping
+	template<typename T>
+	struct ComponentChecksum< Shared<T> >
+	{
+		static uint32_t Update( uint32_t crc, const Shared<T>* components, size_t count )
+		{
+			for( size_t i = 0; i < count; ++i )
+			{
+				const uint32_t valueIndex = components[i].GetValueIndex();
+				crc = crc32_update( &valueIndex, sizeof( valueIndex ), crc );
+			}
+			return crc;
+		}
+	};
+
+	/*
+	*	Stores each distinct value of the shared component type <T> once, along with the entities sharing it
+	*	Values are compared and hashed byte by byte, fully initialize values, padding included, so equal values are found
+	*	A value is released as soon as no entity, prefabs and hibernating entities included, shares it anymore
+	*	Kept up to date by the ComponentManager as the Shared<T> components of entities come and go, like a field index
+	*/
+	template<typename T>
+	class SharedComponentStore : public IFieldIndex
+	{
+		static_assert( std::is_trivially_copyable<T>::value, "Shared component values must be trivially copyable" );
+
+	public:
+		explicit SharedComponentStore( ComponentPool< Shared<T> >* pool ) :
+			m_pool( pool ),
+			m_entityCount( 0 )
+		{}
+
+		/*
+		*	Finds the passed value, storing it if no entity shares it yet
+		*	A stored value without entities is kept until the next call to ReleaseIfUnused or the next entity leaving it
+		*	@return	uint32_t:	The index of the value
+		*/
+		uint32_t Acquire( const T& value )
+		{
+			const uint64_t hash = Hash( value );
+
+			const auto range = m_lookup.equal_range( hash );
+			for( auto it = range.first; it != range.second; ++it )
+			{
+				if( std::memcmp( &m_values[it->second], &value, sizeof( T ) ) == 0 )
+				{
+					return it->second;
+				}
+			}
+
+			uint32_t valueIndex;
+			if( !m_freeValues.empty() )
+			{
+				valueIndex = m_freeValues.back();
+				m_freeValues.pop_back();
+				m_values[valueIndex] = value;
+			}
+			else
+			{
+				valueIndex = static_cast<uint32_t>( m_values.size() );
+				m_values.push_back( value );
+				m_entities.emplace_back();
+				m_hibernatingCounts.push_back( 0 );
+			}
+
+			m_lookup.emplace( hash, valueIndex );
+			return valueIndex;
+		}
+
+		// Releases the value, if no entity shares it
+		void ReleaseIfUnused( uint32_t valueIndex )
+		{
+			if( !m_entities[valueIndex].empty() || m_hibernatingCounts[valueIndex] > 0 )
+			{
+				return;
+			}
+
+			const auto range = m_lookup.equal_range( Hash( m_values[valueIndex] ) );
+			for( auto it = range.first; it != range.second; ++it )
+			{
+				if( it->second == valueIndex )
+				{
+					m_lookup.erase( it );
+					m_freeValues.push_back( valueIndex );
+					return;
+				}
+			}
+		}
+
+		/*
+		*	Moves the entity over to the passed value, the entity must have a Shared<T> component
+		*/
+		void Move( EntityId entityId, uint32_t valueIndex )
+		{
+			Shared<T>* shared = m_pool->Find( entityId );
+			if( shared == nullptr || shared->m_valueIndex == valueIndex )
+			{
+				return;
+			}
+
+			const bool bFiled = IsFiled( entityId, *shared );
+			if( bFiled )
+			{
+				Unfile( entityId, *shared );
+			}
+
+			shared->m_valueIndex = valueIndex;
+			m_pool->MarkChanged( entityId );
+
+			if( bFiled )
+			{
+				File( entityId, *shared );
+			}
+		}
+
+		void Insert( EntityId entityId, const void* ) override
+		{
+			Shared<T>* shared = m_pool->Find( entityId );
+			if( shared != nullptr && !IsFiled( entityId, *shared ) )
+			{
+				File( entityId, *shared );
+			}
+		}
+
+		void Erase( EntityId entityId ) override
+		{
+			Shared<T>* shared = m_pool->Find( entityId );
+			if( shared != nullptr && IsFiled( entityId, *shared ) )
+			{
+				Unfile( entityId, *shared );
+			}
+		}
+
+		// Prefabs hold on to their values, so their instances can share them
+		bool IndexesPrefabs() const override { return true; }
+
+		// The frozen Shared<T> keeps the index of its value, which must not be reused until the entity wakes up
+		void OnHibernate( EntityId entityId ) override
+		{
+			const Shared<T>* shared = m_pool->Find( entityId );
+			if( shared != nullptr && m_hibernatingValues.emplace( entityId, shared->m_valueIndex ).second )
+			{
+				++m_hibernatingCounts[shared->m_valueIndex];
+			}
+		}
+
+		void OnWake( EntityId entityId ) override
+		{
+			const auto hibernatingValue = m_hibernatingValues.find( entityId );
+			if( hibernatingValue == m_hibernatingValues.end() )
+			{
+				return;
+			}
+
+			const uint32_t valueIndex = hibernatingValue->second;
+			m_hibernatingValues.erase( hibernatingValue );
+
+			--m_hibernatingCounts[valueIndex];
+			ReleaseIfUnused( valueIndex );
+		}
+
+		// The number of entities sharing a value
+		inline size_t GetSize() const override { return m_entityCount; }
+
+		// The number of distinct values shared by at least one entity
+		inline size_t GetValueCount() const { return m_values.size() - m_freeValues.size(); }
+
+		/*
+		*	@return	T*:		The value shared by the passed entity, nullptr if the entity shares no value of this type
+		*					The value stays valid until the next value is stored
+		*/
+		const T* Find( EntityId entityId ) const
+		{
+			const Shared<T>* shared = m_pool->Find( entityId );
+			return shared != nullptr && IsFiled( entityId, *shared ) ? &m_values[shared->m_valueIndex] : nullptr;
+		}
+
+		inline const T& GetValue( uint32_t valueIndex ) const { return m_values[valueIndex]; }
+
+		// The entities sharing the value at the passed index, in no particular order
+		inline const std::vector<EntityId>& GetEntities( uint32_t valueIndex ) const { return m_entities[valueIndex]; }
+
+		/*
+		*	Calls the passed function once per shared value, with the value and the entities sharing it
+		*	@param	Function:	Callable with the signature void( const T& value, const std::vector<EntityId>& entities )
+		*/
+		template<typename Function>
+		void ForEach( Function&& function ) const
+		{
+			for( size_t i = 0; i < m_values.size(); ++i )
+			{
+				if( !m_entities[i].empty() )
+				{
+					function( m_values[i], m_entities[i] );
+				}
+			}
+		}
+
+	private:
+		// Returns true, if the entity is amongst the entities of the value its component refers to
+		inline bool IsFiled( EntityId entityId, const Shared<T>& shared ) const
+		{
+			const std::vector<EntityId>& entities = m_entities[shared.m_valueIndex];
+			return shared.m_position < entities.size() && entities[shared.m_position] == entityId;
+		}
+
+		void File( EntityId entityId, Shared<T>& shared )
+		{
+			std::vector<EntityId>& entities = m_entities[shared.m_valueIndex];
+			shared.m_position = static_cast<uint32_t>( entities.size() );
+			entities.push_back( entityId );
+			++m_entityCount;
+		}
+
+		// The last entity sharing the value takes the place of the leaving entity, the value is released once the last entity leaves
+		void Unfile( EntityId entityId, Shared<T>& shared )
+		{
+			std::vector<EntityId>& entities = m_entities[shared.m_valueIndex];
+
+			const EntityId lastEntityId = entities.back();
+			entities[shared.m_position] = lastEntityId;
+			entities.pop_back();
+
+			if( lastEntityId != entityId )
+			{
+				m_pool->Find( lastEntityId )->m_position = shared.m_position;
+			}
+			shared.m_position = IComponentPool::INVALID_INDEX;
+			--m_entityCount;
+
+			ReleaseIfUnused( shared.m_valueIndex );
+		}
+
+		// FNV-1a over the bytes of the value
+		static uint64_t Hash( const T& value )
+		{
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>( &value );
+
+			uint64_t hash = 14695981039346656037ull;
+			for( size_t i = 0; i < sizeof( T ); ++i )
+			{
+				hash = ( hash ^ bytes[i] ) * 1099511628211ull;
+			}
+			return hash;
+		}
+
+		// The Shared<T> components of the entities
+		ComponentPool< Shared<T> >*				m_pool;
+
+		// Every stored value, released values are reused
+		std::vector<T>							m_values;
+
+		// The entities sharing each value, at the same index
+		std::vector< std::vector<EntityId> >	m_entities;
+
+		size_t									m_entityCount;
+
+		// The number of hibernating entities holding each value, at the same index
+		std::vector<uint32_t>					m_hibernatingCounts;
+
+		// The value held by each hibernating entity
+		std::unordered_map<EntityId, uint32_t>	m_hibernatingValues;
+
+		// Indices of released values
+		std::vector<uint32_t>					m_freeValues;
+
+		// The stored values by hash
+		std::unordered_multimap<uint64_t, uint32_t>	m_lookup;
+	};
+}
+
+#endif // !NEBULA_SHAREDCOMPONENTSTORE_H
@@ -0,0 +1,49 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_SIGNATURE_H
+#define NEBULA_SIGNATURE_H
+
+#include "Constants.h"
+#include "../utility/TypeIndex.h"
+
+#include <bitset>
+#include <type_traits>
+
+namespace Nebula
+{
+	// The set of component and tag types present on an entity, one bit per type
+	typedef std::bitset<MAX_COMPONENT_TYPES> Signature;
+
+	/*
+	*	Returns the bit assigned to the passed component or tag type inside of an entity's Signature
+	*	@param	<T>:	The component or tag type
+	*	@return	size_t:	The bit index, a value equal to or greater than MAX_COMPONENT_TYPES means the type cannot be represented
+	*/
+	template<typename T>
+	inline size_t GetSignatureIndex()
+	{
+		return TypeIndex<Signature>::Get<T>();
+	}
+
+	// Recursion ender for SetSignatureBits
+	template<typename ... Rest>
+	inline typename std::enable_if< sizeof...( Rest ) == 0 >::type SetSignatureBits( Signature& )
+	{}
+
+	/*
+	*	Sets the bits of all the passed component or tag types inside of the passed signature
+	*	Types that cannot be represented in a signature are skipped
+	*/
+	template<typename T, typename ... Rest>
+	inline void SetSignatureBits( Signature& signature )
+	{
+		const size_t index = GetSignatureIndex<T>();
+		if( index < MAX_COMPONENT_TYPES )
+		{
+			signature.set( index );
+		}
+		SetSignatureBits<Rest ...>( signature );
+	}
+}
+
+#endif // !NEBULA_SIGNATURE_H
@@ -6,146 +6,535 @@
 #include "ISystem.h"
 #include "Entity.h"
 #include "Component.h"
+#include "Query.h"
+#include "ComponentManager.h"
+#include "QueryMembership.h"
 
 #include "../utility/TemplateHelper.h"
 
+#include <algorithm>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include <iostream>
 
 namespace Nebula 
 {
-	template <typename ... Components>
+	/*
+	*	A System is defined by its query terms, i.e. System<Position, Velocity, Optional<Mass>, Without<FrozenTag>>
+	*	Plain component types and Optional<...> terms make up the ComponentTuple, With<...> and Without<...> only filter
+	*	Hot systems can add the OwningGroup term, to keep their plain component types packed together in the same order, see ComponentGroup
+	*	Systems with the Reactive term receive the entities that entered and left their query, see OnEntitiesAdded and OnEntitiesRemoved
+	*	Systems whose queries have the same ComponentTuple and match the same entities share a single membership, see QueryMembership
+	*/
+	template <typename ... Terms>
 	class System : public ISystem
 	{
 		friend class SystemManager;
 
-		using ComponentTuple = std::tuple< Components* ... >;
+	protected:
+		using SystemQuery = Query<Terms ...>;
+
+		using ComponentTuple = typename SystemQuery::ComponentTuple;
+
+		using Membership = QueryMembership<ComponentTuple>;
 
 	public:
 		explicit System(uint64_t systemId):
-			ISystem(systemId)
+			ISystem(systemId),
+			m_membership(nullptr),
+			m_group(nullptr),
+			m_packedMembershipVersion(0)
 		{}
 		virtual ~System() override = default;
 
 		virtual void Update( float deltaTime ) override {}
 
-		std::vector<ComponentTuple>& GetComponents() { return m_components; }
+		// The components of every entity of this system, disabled entities included, shared with every system of the same query
+		// Only valid once the system is registered
+		std::vector<ComponentTuple>& GetComponents() { return m_membership->GetComponents(); }
 
-	private:
-		// The list of Component Tuples, where each tuple is a set of components owned by the same entity
-		std::vector<ComponentTuple>			m_components;
-		
-		// If the passed entity's components match this system's signature, the components will be added to this system
-		// If not, then we check to see if any of the entity's components are in the system and remove them
-		virtual void OnEntitySignatureChanged( const Entity& entity ) override final
+		// The owning entity of each element of GetComponents(), at the same index
+		const std::vector<EntityId>& GetEntities() const { return m_membership->GetEntities(); }
+
+		// The entities of this system, shared with every other registered system of the same query
+		Membership* GetMembership() const { return m_membership; }
+
+		// The owning group of this system, nullptr if the system has no OwningGroup term or its component types are owned by another group
+		ComponentGroup* GetGroup() const { return m_group; }
+
+		// Returns the ComponentTuple of the passed entity, nullptr if the entity is not in this system
+		ComponentTuple* FindComponents( EntityId entityId )
+		{
+			const size_t index = m_membership->GetIndex( entityId );
+			return index != INVALID_INDEX ? &m_membership->GetComponents()[index] : nullptr;
+		}
+
+		/*
+		*	The range [first, second) of GetComponents() processed by the current update, all components unless time slicing is on
+		*/
+		std::pair<size_t, size_t> GetUpdateRange() const
+		{
+			const size_t size = GetEntities().size();
+			const size_t slices = GetTimeSlices();
+			const size_t slice = GetCurrentSlice();
+
+			return std::make_pair( size * slice / slices, size * ( slice + 1 ) / slices );
+		}
+
+		/*
+		*	Calls the passed function with the ComponentTuple of each enabled entity processed by the current update
+		*	Writes made through the tuples are not seen by the world checksum, see ComponentManager::MarkComponentsChanged
+		*	@param	Function:	Callable with the signature void( ComponentTuple& )
+		*/
+		template<typename Function>
+		void ForEach( Function&& function )
 		{
+			const std::pair<size_t, size_t> range = GetUpdateRange();
 
-			int NumberOfComponents = sizeof...( Components );
-			int NumberOfMatchingComponents = 0;
+			std::vector<ComponentTuple>& components = GetComponents();
+			const std::vector<EntityId>& entities = GetEntities();
+
+			const ComponentManager* componentManager = GetComponentManager();
+			if( componentManager == nullptr || !componentManager->HasDisabledEntities() )
+			{
+				for( size_t i = range.first; i < range.second; ++i )
+				{
+					function( components[i] );
+				}
+				return;
+			}
 
-			ComponentTuple componentTuple;
-			for ( auto* c : entity.GetComponents() )	// For all the components on the entity
+			for( size_t i = range.first; i < range.second; ++i )
 			{
-				if ( c != nullptr )
+				if( componentManager->IsEntityEnabled( entities[i] ) )
 				{
-					
-					if (ProcessEntityComponent<0, Components ...>(c, componentTuple)) 
-						// When a component matches any of the acceptable types of component for this system
-						// Increment the number of matching components
-					{		
-						++NumberOfMatchingComponents;
+					function( components[i] );
+				}
+			}
+		}
+
+		/*
+		*	Iterates the components of this system chunk by chunk, for vectorized processing
+		*	i.e. ForEachChunk<Position, Velocity>( []( size_t count, Position* positions, Velocity* velocities ) {} );
+		*	Each call receives the number of entities in the chunk, and a pointer to the first of 'count' contiguous components of each requested type
+		*	Every pointer is aligned to COMPONENT_CHUNK_ALIGNMENT, index i of every array belongs to the same entity
+		*	When the system matches exactly the entities of the group owning the requested types, the group's packed arrays are iterated as they are
+		*	Otherwise the requested pools are packed in the order of this system's entities, and stay claimed by this system's query until it is unregistered
+		*	When a requested type is owned by another group, or its pool is claimed by another query, its order is left alone, the longest contiguous runs are passed instead and are not aligned
+		*	Disabled entities are skipped, a chunk holding disabled entities is passed as the runs of enabled entities around them, only the first run is aligned
+		*	With time slicing on, only the chunks of the current slice are iterated
+		*	Every chunk passed to the function is flagged as changed for the world checksum, see ComponentManager::GetChecksum
+		*	@param	<Components>:	The component types to iterate, must be required (non-optional) components of this system
+		*	@param	Function:		Callable with the signature void( size_t count, Components* ... )
+		*/
+		template<typename ... Components, typename Function>
+		void ForEachChunk( Function&& function )
+		{
+			static_assert( sizeof...( Components ) > 0, "ForEachChunk requires at least one component type" );
 
-						
-						if (NumberOfMatchingComponents == NumberOfComponents) {
+			ComponentManager* componentManager = GetComponentManager();
+			if( componentManager == nullptr || m_membership == nullptr || GetEntities().empty() )
+			{
+				return;
+			}
 
-							// TODO:
-							// Make sure this entity's Components do not already exist on this system before adding them
-							// Instead if they do exist remove them
-							// This can end up being a lot of looping!
-							for (size_t i = 0; i < m_components.size(); i++) {
+			Signature requested;
+			SetSignatureBits<Components ...>( requested );
+			if( ( requested & SystemQuery::GetRequiredMask() ) != requested )	// Only required components are guaranteed to be on every entity
+			{
+				return;
+			}
 
-								Component* c = std::get<0>(m_components[i]);
+			ComponentGroup* groups[] = { componentManager->GetPool<Components>()->GetGroup() ... };
 
-								if (c->GetOwnerEntity() == entity.GetId()) {
+			bool bSameGroup = groups[0] != nullptr;
+			bool bNoGroup = true;
+			for( ComponentGroup* group : groups )
+			{
+				bSameGroup = bSameGroup && group == groups[0];
+				bNoGroup = bNoGroup && group == nullptr;
+			}
 
-									m_components[i] = m_components[m_components.size() - 1];
-									m_components.pop_back();
-									break;
+			// Groups leave out prefabs just like queries do, hibernating entities have no components to group
+			Signature excludedByDefault;
+			SetSignatureBits<Prefab, Hibernating>( excludedByDefault );
 
-								}
-							}
+			// Every entity of this system is in a group with the same signature, equal sizes mean equal sets of entities
+			if( bSameGroup && groups[0]->GetMask() == SystemQuery::GetRequiredMask() && ( SystemQuery::GetExcludedMask() & ~excludedByDefault ).none() && groups[0]->GetSize() == GetEntities().size() )
+			{
+				// The group holds exactly the entities of this system, at the front of each pool
+				IterateChunks<Components ...>( *componentManager, groups[0]->GetSize(), function );
+			}
+			else if( bNoGroup && PackChunks<Components ...>( *componentManager ) )
+			{
+				IterateChunks<Components ...>( *componentManager, GetEntities().size(), function );
+			}
+			else
+			{
+				IterateRuns<Components ...>( *componentManager, function );
+			}
+		}
 
-							// Add the created tuple to this system 
-							m_components.push_back(componentTuple);
-							break;
-						}
+		/*
+		*	Calls the passed function once per value of the shared component type <T>, with the ComponentTuples of the enabled entities of this system sharing it
+		*	Entities sharing a value are processed together, i.e. everything drawn with the same mesh, time slicing does not apply
+		*	@param	<T>:		The shared component type, see ComponentManager::SetSharedComponent
+		*	@param	Function:	Callable with the signature void( const T& value, const std::vector<ComponentTuple*>& tuples )
+		*/
+		template<typename T, typename Function>
+		void ForEachShared( Function&& function )
+		{
+			const ComponentManager* componentManager = GetComponentManager();
+			const SharedComponentStore<T>* store = componentManager != nullptr ? componentManager->FindSharedStore<T>() : nullptr;
+			if( store == nullptr )
+			{
+				return;
+			}
 
+			std::vector<ComponentTuple*> tuples;
+			store->ForEach( [&]( const T& value, const std::vector<EntityId>& entities )
+			{
+				tuples.clear();
+				for( const EntityId entityId : entities )
+				{
+					ComponentTuple* tuple = FindComponents( entityId );
+					if( tuple != nullptr && componentManager->IsEntityEnabled( entityId ) )
+					{
+						tuples.push_back( tuple );
 					}
+				}
+
+				if( !tuples.empty() )
+				{
+					function( value, tuples );
+				}
+			} );
+		}
+
+	protected:
+		/*
+		*	Reactive systems only, called once right before Update, with every entity that entered this system's query since the previous update
+		*	The first call also holds every entity that already matched the query when the system was registered
+		*	The entities are still in the system, their components can be found with FindComponents
+		*	@param	Entities:	The entities that entered
+		*/
+		virtual void OnEntitiesAdded( const std::vector<EntityId>& /* entities */ ) {}
+
+		/*
+		*	Reactive systems only, called once right before Update and before OnEntitiesAdded, with every entity that left this system's query since the previous update
+		*	The entities are no longer in the system, and may not exist anymore
+		*	An entity that left and entered again is passed to both, an entity that entered and left again is passed to neither
+		*	@param	Entities:	The entities that left, in the order they left
+		*/
+		virtual void OnEntitiesRemoved( const std::vector<EntityId>& /* entities */ ) {}
+
+	private:
+		// Sentinel for an entity that is not in this system
+		static constexpr size_t INVALID_INDEX = static_cast<size_t>( -1 );
+
+		// The Component Tuples of the entities matching this system's query, and their owning entities
+		Membership*							m_membership;
 
+		// The group created for the OwningGroup term
+		ComponentGroup*						m_group;
+
+		// Reactive systems only, the entities that entered and left since the last update
+		std::vector<EntityId>				m_addedEntities;
+		std::vector<EntityId>				m_removedEntities;
+
+		// Index of each entity inside of 'm_addedEntities', indexed by EntityId
+		std::vector<size_t>					m_addedIndices;
+
+		// The pools packed by the last call to ForEachChunk, and their layout versions right after packing
+		std::vector< std::pair<IComponentPool*, uint64_t> >	m_packedPools;
+		uint64_t							m_packedMembershipVersion;
+
+		virtual void OnRegistered( SystemManager& systemManager ) override
+		{
+			m_membership = systemManager.AcquireMembership<Membership>( SystemQuery::GetRequiredMask(), SystemQuery::GetExcludedMask() );
+			if( SystemQuery::bReactive )
+			{
+				m_membership->AddObserver( this );
+
+				// The entities matching before this system was registered enter it in one batch, right before its first update
+				m_addedEntities.reserve( m_membership->GetEntities().size() );
+				for( const EntityId entityId : m_membership->GetEntities() )
+				{
+					OnEntityAdded( entityId );
 				}
-				else // The moment we find a null component, we now we are at the end of the array, no need to continue
+			}
+
+			if( SystemQuery::bOwningGroup && GetComponentManager() != nullptr )
+			{
+				m_group = CreateGroup( *GetComponentManager(), static_cast<typename SystemQuery::OwnedTuple*>( nullptr ) );
+			}
+		}
+
+		virtual void OnUnregistered( SystemManager& systemManager ) override
+		{
+			if( m_membership != nullptr )
+			{
+				// The pools packed for the membership are free to be packed by other queries once nobody shares it
+				if( m_membership->GetSystemCount() == 1 && GetComponentManager() != nullptr )
 				{
-					break;
+					GetComponentManager()->ReleasePackedPools( m_membership );
 				}
 
+				m_membership->RemoveObserver( this );
+				systemManager.ReleaseMembership( m_membership );
+				m_membership = nullptr;
 			}
+		}
 
-			if (NumberOfMatchingComponents != NumberOfComponents) {	
-				// If this entity'components do not match this system, lets look to see if the entity's components are already in the system
+		virtual void DispatchMembershipChanges() override
+		{
+			if( !m_removedEntities.empty() )
+			{
+				OnEntitiesRemoved( m_removedEntities );
+				m_removedEntities.clear();
+			}
 
-				for (size_t i = 0; i < m_components.size(); i++) {
+			if( !m_addedEntities.empty() )
+			{
+				OnEntitiesAdded( m_addedEntities );
 
-					Component* c = std::get<0>(m_components[i]);
+				for( const EntityId entityId : m_addedEntities )
+				{
+					m_addedIndices[entityId] = INVALID_INDEX;
+				}
+				m_addedEntities.clear();
+			}
+		}
 
-					if (c->GetOwnerEntity() == entity.GetId()) {
+		// Records an entity that entered this system's query
+		virtual void OnEntityAdded( EntityId entityId ) override
+		{
+			if( entityId >= m_addedIndices.size() )
+			{
+				m_addedIndices.resize( entityId + 1, INVALID_INDEX );
+			}
 
-						m_components[i] = m_components[m_components.size() - 1];
-						m_components.pop_back();
-						break;
+			m_addedIndices[entityId] = m_addedEntities.size();
+			m_addedEntities.push_back( entityId );
+		}
 
-					}
+		// Records an entity that left this system's query, an entity that only just entered is forgotten instead
+		virtual void OnEntityRemoved( EntityId entityId ) override
+		{
+			const size_t index = entityId < m_addedIndices.size() ? m_addedIndices[entityId] : INVALID_INDEX;
+			if( index == INVALID_INDEX )
+			{
+				m_removedEntities.push_back( entityId );
+				return;
+			}
+
+			// Replace the entity with the last entity that entered
+			m_addedEntities[index] = m_addedEntities.back();
+			m_addedIndices[m_addedEntities[index]] = index;
+			m_addedEntities.pop_back();
+			m_addedIndices[entityId] = INVALID_INDEX;
+		}
+
+		template<typename ... Components>
+		static ComponentGroup* CreateGroup( ComponentManager& componentManager, std::tuple<Components ...>* )
+		{
+			return componentManager.CreateGroup<Components ...>();
+		}
+
+		// Passes the first 'count' components of each requested pool to the function, chunk by chunk, honouring the current time slice
+		// Chunks are pinned while they are processed, the next chunk is pinned ahead of time so it can be read in the meantime
+		template<typename ... Components, typename Function>
+		void IterateChunks( ComponentManager& componentManager, size_t count, Function& function )
+		{
+			const size_t chunkCount = ( count + COMPONENT_CHUNK_CAPACITY - 1 ) / COMPONENT_CHUNK_CAPACITY;
+			const size_t slices = GetTimeSlices();
+			const size_t slice = GetCurrentSlice();
+
+			IComponentPool* pools[] = { componentManager.FindPool<Components>() ... };
+
+			const size_t firstChunk = chunkCount * slice / slices;
+			const size_t lastChunk = chunkCount * ( slice + 1 ) / slices;
+
+			if( firstChunk < lastChunk )
+			{
+				PinChunk( pools, firstChunk );
+			}
+
+			for( size_t chunk = firstChunk; chunk < lastChunk; ++chunk )
+			{
+				if( chunk + 1 < lastChunk )
+				{
+					PinChunk( pools, chunk + 1 );
+				}
+
+				const size_t first = chunk * COMPONENT_CHUNK_CAPACITY;
+				const size_t chunkSize = std::min( COMPONENT_CHUNK_CAPACITY, count - first );
+				if( componentManager.HasDisabledEntities() )
+				{
+					IterateEnabledRuns<Components ...>( componentManager, first, chunkSize, function );
+				}
+				else
+				{
+					function( chunkSize, componentManager.FindPool<Components>()->GetChunk( chunk ) ... );
 				}
 
+				// The function may have written to the chunk
+				for( IComponentPool* pool : pools )
+				{
+					pool->UnpinChunk( chunk );
+					pool->MarkChunkChanged( chunk );
+				}
 			}
+		}
+
+		// Passes the runs of enabled entities amongst the 'count' components starting at index 'first' of each requested pool
+		template<typename ... Components, typename Function>
+		static void IterateEnabledRuns( ComponentManager& componentManager, size_t first, size_t count, Function& function )
+		{
+			// Every requested pool holds the components of the same entities, in the same order
+			const IComponentPool* pools[] = { componentManager.FindPool<Components>() ... };
+			const std::vector<EntityId>& entities = pools[0]->GetEntities();
+
+			const size_t last = first + count;
+			size_t runStart = first;
+			while( runStart < last )
+			{
+				while( runStart < last && !componentManager.IsEntityEnabled( entities[runStart] ) )
+				{
+					++runStart;
+				}
 
-			// Loop through the component tuple
+				size_t runEnd = runStart;
+				while( runEnd < last && componentManager.IsEntityEnabled( entities[runEnd] ) )
+				{
+					++runEnd;
+				}
 
+				if( runEnd > runStart )
+				{
+					function( runEnd - runStart, componentManager.FindPool<Components>()->Get( runStart ) ... );
+				}
+				runStart = runEnd;
+			}
 		}
 
-	private:
+		template<size_t POOL_COUNT>
+		static void PinChunk( IComponentPool* const ( &pools )[POOL_COUNT], size_t chunk )
+		{
+			for( IComponentPool* pool : pools )
+			{
+				pool->PinChunk( chunk );
+			}
+		}
 
-		// Checks to see if the passed Component's Type matches the type of component type required for this system
-		// If true, returns true, otherwise recursively checks the passed component's type agains all acceptable component types
-		// If there is no match returns false
-		template<size_t INDEX, class ComponentClass /*Current Component Class*/, class ... Components>
-		bool ProcessEntityComponent( Component* component, ComponentTuple& tupleToFill) 
+		// Passes the entities of the current update to the function, grouped into runs that are contiguous and within one chunk in every requested pool
+		template<typename ... Components, typename Function>
+		void IterateRuns( ComponentManager& componentManager, Function& function )
 		{
-			
-			// Complile-time check to see if class T can be converted to class B, 
-				// valid for derivation check of class T from class B
-			CanConvert_From<ComponentClass, Component>();
+			const IComponentPool* pools[] = { componentManager.FindPool<Components>() ... };
+			const size_t poolCount = sizeof...( Components );
 
-			if (ComponentClass::ID == component->GetComponentType()) {
+			uint32_t starts[sizeof...( Components )] = {};
+			size_t runLength = 0;
 
-				std::get<INDEX>(tupleToFill) = dynamic_cast<ComponentClass*>(component);
-				return true;
+			const bool bHasDisabledEntities = componentManager.HasDisabledEntities();
+
+			const std::vector<EntityId>& entities = GetEntities();
+
+			const std::pair<size_t, size_t> range = GetUpdateRange();
+			for( size_t i = range.first; i < range.second; ++i )
+			{
+				if( bHasDisabledEntities && !componentManager.IsEntityEnabled( entities[i] ) )
+				{
+					// A disabled entity ends the current run
+					if( runLength > 0 )
+					{
+						CallWithRun<Components ...>( componentManager, function, runLength, starts, std::index_sequence_for<Components ...>() );
+						runLength = 0;
+					}
+					continue;
+				}
+
+				bool bExtendsRun = runLength > 0 && runLength < COMPONENT_CHUNK_CAPACITY;
+				for( size_t p = 0; bExtendsRun && p < poolCount; ++p )
+				{
+					const uint32_t index = pools[p]->GetIndex( entities[i] );
+					bExtendsRun = index == starts[p] + runLength && index % COMPONENT_CHUNK_CAPACITY != 0;
+				}
+
+				if( !bExtendsRun )
+				{
+					if( runLength > 0 )
+					{
+						CallWithRun<Components ...>( componentManager, function, runLength, starts, std::index_sequence_for<Components ...>() );
+					}
+
+					for( size_t p = 0; p < poolCount; ++p )
+					{
+						starts[p] = pools[p]->GetIndex( entities[i] );
+					}
+					runLength = 0;
+				}
+
+				++runLength;
+			}
 
+			if( runLength > 0 )
+			{
+				CallWithRun<Components ...>( componentManager, function, runLength, starts, std::index_sequence_for<Components ...>() );
 			}
-			else {
-				// We drop the ComponentClass with each loop of recursion
-				// When we run out of ComponentClasses to check, we return false, via the recursive ender
-				return ProcessEntityComponent<INDEX + 1, Components ... >(component, tupleToFill);
+		}
+
+		template<typename ... Components, typename Function, size_t ... INDICES>
+		static void CallWithRun( ComponentManager& componentManager, Function& function, size_t count, const uint32_t* starts, std::index_sequence<INDICES ...> )
+		{
+			// Runs never cross a chunk boundary, the function may have written to the chunk of each run
+			IComponentPool* pools[] = { componentManager.FindPool<Components>() ... };
+			for( size_t p = 0; p < sizeof...( Components ); ++p )
+			{
+				pools[p]->MarkChunkChanged( starts[p] / COMPONENT_CHUNK_CAPACITY );
 			}
 
+			function( count, componentManager.FindPool<Components>()->Get( starts[INDICES] ) ... );
 		}
 
-		template<size_t INDEX>
-		bool ProcessEntityComponent(Component* component, ComponentTuple& tupleToFill) {
-			return false;
+		// Makes index i of each requested pool hold the component of GetEntities()[i], skipped when nothing moved since the last packing
+		// Returns false if a pool is claimed by another query, see ComponentManager::PackComponents
+		template<typename ... Components>
+		bool PackChunks( ComponentManager& componentManager )
+		{
+			IComponentPool* pools[] = { componentManager.GetPool<Components>() ... };
+
+			bool bPacked = m_packedMembershipVersion == m_membership->GetMembershipVersion() && m_packedPools.size() == sizeof...( Components );
+			for( size_t i = 0; bPacked && i < sizeof...( Components ); ++i )
+			{
+				bPacked = m_packedPools[i].first == pools[i] && m_packedPools[i].second == pools[i]->GetLayoutVersion();
+			}
+
+			if( bPacked )
+			{
+				return true;
+			}
+
+			if( !componentManager.PackComponents<Components ...>( GetEntities(), m_membership ) )
+			{
+				return false;
+			}
+
+			m_packedPools.clear();
+			for( IComponentPool* pool : pools )
+			{
+				m_packedPools.emplace_back( pool, pool->GetLayoutVersion() );
+			}
+			m_packedMembershipVersion = m_membership->GetMembershipVersion();
+			return true;
 		}
 	};
+
+	template <typename ... Terms>
+	constexpr size_t System<Terms ...>::INVALID_INDEX;
 }
 
 
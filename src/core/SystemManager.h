@@ -6,8 +6,12 @@
 #include "../utility/TemplateHelper.h"
 #include "Constants.h"
 #include "ISystem.h"
+#include "IQueryMembership.h"
 
-#include <array>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <vector>
 
 namespace Nebula
 {
@@ -16,8 +20,18 @@ namespace Nebula
 	{
 		friend class ComponentManager;
 
-		// Linked-list of active Systems on this System Manager
-		std::array<ISystem*, MAX_SYSTEMS> m_activeSystems;
+	public:
+		/*
+		*	Called right after an update of a system took longer than its budget, see ISystem::SetLatencyBudget
+		*	@param	System:			The system that went over its budget
+		*	@param	Nanoseconds:	The time the update took
+		*/
+		using BudgetExceededCallback = std::function<void( const ISystem& system, uint64_t nanoseconds )>;
+
+	private:
+
+		// Active Systems on this System Manager, in the order they update
+		std::vector<ISystem*> m_activeSystems;
 
 		// The Number of Systems active inside of this System Manager
 		uint64_t m_systemsCounter;
@@ -25,14 +39,32 @@ namespace Nebula
 		// The world this System Manager belongs to
 		class World* m_world;
 
+		// The component manager of the world this System Manager belongs to
+		class ComponentManager* m_componentManager;
+
+		// One membership per distinct query of the active systems, shared by every system with that query
+		std::vector<IQueryMembership*> m_memberships;
+
+		// The most systems active at once, see WorldLimits::m_maxSystems
+		size_t m_maxSystems;
+
+		// Called whenever an update of a system takes longer than its budget
+		BudgetExceededCallback m_budgetExceededCallback;
+
 	public:
 
-		SystemManager() : m_activeSystems(), m_systemsCounter( 0 ), m_world( nullptr )
+		explicit SystemManager( size_t maxSystems = WorldLimits().m_maxSystems ) : m_activeSystems(), m_systemsCounter( 0 ), m_world( nullptr ), m_componentManager( nullptr ), m_memberships(), m_maxSystems( maxSystems ), m_budgetExceededCallback()
 		{}
 
 		~SystemManager()
 		{
 			UnregisterAllSystems();
+
+			for( auto* membership : m_memberships )
+			{
+				delete membership;
+			}
+			m_memberships.clear();
 		}
 
 		inline void SetWorld( World* world )
@@ -40,6 +72,11 @@ namespace Nebula
 			m_world = world;
 		}
 
+		inline void SetComponentManager( ComponentManager* componentManager )
+		{
+			m_componentManager = componentManager;
+		}
+
 
 		// Add a System to this System Manager
 		template <typename T, typename ... Args>
@@ -49,7 +86,7 @@ namespace Nebula
 				// valid for derivation check of class T from class B
 			CanConvert_From<T, ISystem>();
 
-			if( m_systemsCounter >= MAX_SYSTEMS )
+			if( m_systemsCounter >= m_maxSystems )
 			{
 				return nullptr;
 			}
@@ -62,10 +99,13 @@ namespace Nebula
 			}
 
 			system->m_world = this->m_world;
+			system->m_componentManager = this->m_componentManager;
 			system->m_systemManagerId = this->m_systemsCounter;
-			m_activeSystems[this->m_systemsCounter] = system;
+			m_activeSystems.push_back( system );
 			++m_systemsCounter;
 
+			system->OnRegistered( *this );
+
 			return system;
 
 		}
@@ -94,13 +134,14 @@ namespace Nebula
 						const uint64_t lastIndex = --this->m_systemsCounter;
 
 						m_activeSystems[systemManagerId] = m_activeSystems[lastIndex];
-						m_activeSystems[lastIndex] = nullptr;
+						m_activeSystems.pop_back();
 
-						if( m_activeSystems[systemManagerId] != nullptr )
+						if( systemManagerId < m_activeSystems.size() )
 						{
 							m_activeSystems[systemManagerId]->m_systemManagerId = systemManagerId;
 						}
 
+						system->OnUnregistered( *this );
 						delete system, system = nullptr;
 
 						break;
@@ -148,31 +189,148 @@ namespace Nebula
 			return nullptr;
 		}
 
-		// Calls Update on all active systems, inside of this system manager
+		// Calls Update on all active systems that are due, inside of this system manager, recording the time each update takes
 		void Update( float deltaTime )
 		{
+			float systemDeltaTime = 0.0f;
 			for( auto* s : m_activeSystems )
 			{
-				if( s != nullptr )
-					s->Update( deltaTime );
-				else
+				if( s == nullptr )
 					break;
+
+				if( s->AdvanceTime( deltaTime, systemDeltaTime ) )
+				{
+					// The dispatch of the membership changes is part of the update's latency
+					const auto start = std::chrono::steady_clock::now();
+					s->DispatchMembershipChanges();
+					s->Update( systemDeltaTime );
+					const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start ).count();
+
+					RecordLatency( *s, static_cast<uint64_t>( elapsed ) );
+				}
+			}
+		}
+
+		// Replaces the function called whenever an update of a system takes longer than its budget, pass nullptr to stop reporting
+		inline void SetBudgetExceededCallback( BudgetExceededCallback callback )
+		{
+			m_budgetExceededCallback = std::move( callback );
+		}
+
+		/*
+		*	Copies the latency histogram of every active system, in the order the systems update
+		*	@param	Snapshots:	Receives one snapshot per active system, previous contents are replaced
+		*	@param	bReset:		Starts every histogram and over budget count over once copied, i.e. for one snapshot per scrape interval
+		*/
+		void GetLatencySnapshots( std::vector<LatencySnapshot>& snapshots, bool bReset = false )
+		{
+			snapshots.resize( m_activeSystems.size() );
+			for( size_t i = 0; i < m_activeSystems.size(); ++i )
+			{
+				ISystem* system = m_activeSystems[i];
+
+				LatencySnapshot& snapshot = snapshots[i];
+				snapshot.m_systemId = system->m_systemId;
+				snapshot.m_budgetNanoseconds = system->m_latencyBudget;
+				snapshot.m_overBudgetCount = system->m_overBudgetCount;
+				system->m_latencyHistogram.FillSnapshot( snapshot );
+
+				if( bReset )
+				{
+					system->m_latencyHistogram.Reset();
+					system->m_overBudgetCount = 0;
+				}
 			}
 		}
 
+		/*
+		*	Returns the membership of the passed query, shared with every other system asking for the same one, created on first use
+		*	A new membership starts out with every existing entity matching the query
+		*	Every call must be matched by a call to ReleaseMembership
+		*	@param	<T>:			The membership type, a QueryMembership of the query's ComponentTuple
+		*	@param	RequiredMask:	The component and tag types a member must have
+		*	@param	ExcludedMask:	The component and tag types a member must not have
+		*/
+		template<typename T>
+		T* AcquireMembership( const Signature& requiredMask, const Signature& excludedMask )
+		{
+			const size_t typeIndex = TypeIndex<IQueryMembership>::Get<T>();
+
+			for( auto* membership : m_memberships )
+			{
+				if( membership->IsQuery( typeIndex, requiredMask, excludedMask ) )
+				{
+					++membership->m_systemCount;
+					return static_cast< T* >( membership );
+				}
+			}
+
+			T* membership = new T( m_componentManager, typeIndex, requiredMask, excludedMask );
+			membership->m_systemCount = 1;
+			m_memberships.push_back( membership );
+
+			// A system registered after its entities were created sees them all, just like one registered before
+			membership->MatchExistingEntities();
+
+			return membership;
+		}
+
+		// Deletes the passed membership once the last system sharing it lets go
+		void ReleaseMembership( IQueryMembership* membership )
+		{
+			if( membership == nullptr || --membership->m_systemCount > 0 )
+			{
+				return;
+			}
+
+			m_memberships.erase( std::remove( m_memberships.begin(), m_memberships.end(), membership ), m_memberships.end() );
+			delete membership;
+		}
+
+		// The number of distinct queries of the active systems
+		inline size_t GetMembershipCount() const { return m_memberships.size(); }
+
 	private:
-		// Updates Systems in the manager when an entity's signature has changed update the system manager's systems
-		void OnEntitySignatureChanged( const Entity& entity )
+		void RecordLatency( ISystem& system, uint64_t nanoseconds )
 		{
-			for( const auto& s : m_activeSystems )
+			system.m_latencyHistogram.Record( nanoseconds );
+
+			if( system.m_latencyBudget > 0 && nanoseconds > system.m_latencyBudget )
 			{
-				if( s != nullptr )
+				++system.m_overBudgetCount;
+				if( m_budgetExceededCallback )
 				{
-					s->OnEntitySignatureChanged( entity );
+					m_budgetExceededCallback( system, nanoseconds );
 				}
-				else // The moment we find a null system, we now we are at the end of the array, no need to continue
+			}
+		}
+
+		// Updates the membership of every distinct query when an entity's signature has changed, once per query however many systems share it
+		void OnEntitySignatureChanged( const Entity& entity )
+		{
+			for( auto* membership : m_memberships )
+			{
+				membership->OnEntitySignatureChanged( entity );
+			}
+		}
+
+		// Updates the membership of every distinct query when the signatures of many entities have changed, one query at a time
+		void OnEntitiesSignatureChanged( const std::vector<Entity*>& entities )
+		{
+			for( auto* membership : m_memberships )
+			{
+				membership->OnEntitiesSignatureChanged( entities );
+			}
+		}
+
+		// Points the ComponentTuples holding the moved component's type at its new place, the entity's signature is unchanged
+		void OnComponentRelocated( EntityId entityId, size_t signatureIndex )
+		{
+			for( auto* membership : m_memberships )
+			{
+				if( membership->m_tupleMask.test( signatureIndex ) )
 				{
-					break;
+					membership->OnComponentRelocated( entityId, signatureIndex );
 				}
 			}
 		}
@@ -184,11 +342,14 @@ namespace Nebula
 				if( s != nullptr )
 				{
 
+					s->OnUnregistered( *this );
 					delete s, s = nullptr;
 
 				}
 
 			}
+			m_activeSystems.clear();
+			m_systemsCounter = 0;
 
 			return m_activeSystems.empty();
 		}
@@ -6,9 +6,18 @@
 #include "EntityManager.h"
 #include "ComponentManager.h"
 #include "SystemManager.h"
+#include "ResourceManager.h"
+#include "CommandBuffer.h"
+#include "IngestionQueue.h"
+#include "EventBus.h"
 
 #include "../utility/TemplateHelper.h"
+#include "../utility/ThreadLocalSlot.h"
 
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <utility>
 #include <vector>
 
 namespace Nebula
@@ -21,20 +30,58 @@ namespace Nebula
 
 		ComponentManager* m_componentManager;
 
+		ResourceManager* m_resourceManager;
+
+		// Holds each thread's command buffer of this world, forgotten by every thread along with the world
+		ThreadLocalSlot m_commandBufferSlot;
+
+		// The command buffer of every thread that has recorded changes to this world
+		std::vector<CommandBuffer*> m_commandBuffers;
+
+		// Guards 'm_commandBuffers', only taken the first time a thread asks for its command buffer
+		std::mutex m_commandBuffersMutex;
+
+		// The queues streaming records into this world, drained by Maintain
+		std::vector<IIngestionQueue*> m_ingestionQueues;
+
+		// The events systems send to each other, swapped at the end of every update
+		EventBus* m_eventBus;
+
 		template<typename ... T>
 		friend struct Parser;
 
 	public:
-		World() :
-			m_enityManager( new EntityManager() ),
-			m_systemManager( new SystemManager() ),
-			m_componentManager( new ComponentManager( m_enityManager, m_systemManager ) )
+		/*
+		*	@param	Limits:		The capacity of this world, storage grows on demand up to these limits, see WorldLimits
+		*/
+		explicit World( const WorldLimits& limits = WorldLimits() ) :
+			m_enityManager( new EntityManager( limits.m_maxEntities ) ),
+			m_systemManager( new SystemManager( limits.m_maxSystems ) ),
+			m_componentManager( new ComponentManager( m_enityManager, m_systemManager, limits ) ),
+			m_resourceManager( new ResourceManager() ),
+			m_commandBufferSlot(),
+			m_eventBus( new EventBus() )
 		{
 			m_systemManager->SetWorld( this );
+			m_systemManager->SetComponentManager( m_componentManager );
 		}
 		
 		~World()
 		{
+			// Changes that were never flushed are dropped
+			for ( auto* commandBuffer : m_commandBuffers )
+			{
+				delete commandBuffer;
+			}
+			m_commandBuffers.clear();
+
+			// So are records that were never drained
+			for ( auto* ingestionQueue : m_ingestionQueues )
+			{
+				delete ingestionQueue;
+			}
+			m_ingestionQueues.clear();
+
 			// Each Manager will handle the destruction of their items
 
 			// Systems get deleted first
@@ -44,6 +91,20 @@ namespace Nebula
 				m_systemManager = nullptr;
 			}
 
+			// Events are only sent and read by systems, as are resources
+			if ( m_eventBus )
+			{
+				delete m_eventBus;
+				m_eventBus = nullptr;
+			}
+
+			// Resources are only referenced by systems, they can go right after
+			if ( m_resourceManager )
+			{
+				delete m_resourceManager;
+				m_resourceManager = nullptr;
+			}
+
 			// Now we remove all components from the component manager
 			if ( m_componentManager )
 			{
@@ -103,13 +164,231 @@ namespace Nebula
 			return createdEntities;
 		}
 
-		// Destroys Entity with the passed EntityId, removing all components in the process
+		// Creates an entity tagged with Prefab, add components to it like any other entity and pass it to Instantiate
+		// Prefabs are not matched by systems, returns 0 if the entity could not be created
+		EntityId CreatePrefab()
+		{
+			const EntityId prefabId = m_enityManager->CreateEntity();
+
+			if ( prefabId != 0 )
+			{
+				m_componentManager->AddTag<Prefab>( prefabId );
+			}
+
+			return prefabId;
+		}
+
+		// Will create 'n' number of entities, each with a copy of the passed prefab's components and tags, Returns vector of the entityIds
+		// Components are copied type by type, and the systems are updated once for the whole batch
+		// Returns an empty vector if the prefab is hibernating, a component of the prefab cannot be copied, or the copies would exceed the component limit
+		std::vector<EntityId> Instantiate( EntityId prefabId, uint64_t numberOfEntities )
+		{
+			std::vector<EntityId> createdEntities = CreateEntities( numberOfEntities );
+
+			if ( !m_componentManager->Instantiate( prefabId, createdEntities ) )
+				// The prefab does not exist or cannot be copied, nothing to instantiate
+			{
+				for ( const EntityId entityId : createdEntities )
+				{
+					DestroyEntity( entityId );
+				}
+				createdEntities.clear();
+			}
+
+			return createdEntities;
+		}
+
+		// Destroys Entity with the passed EntityId, the entity immediately leaves its systems
+		// Its components and its EntityId are reclaimed later, by Maintain
 		void DestroyEntity( EntityId entityId )
 		{
-			m_componentManager->RemoveAllComponents( entityId );
+			m_componentManager->MarkComponentsForCleanUp( entityId );
 			m_enityManager->MarkEntityForCleanUp( entityId );
 		}
 
+		/*
+		*	Reclaims the components, entities and EntityIds left behind by destroyed entities, meant to run at the end of a world update
+		*	Work stops as soon as either budget is spent, the remaining entities are reclaimed by the next calls
+		*	@param	MaxEntities:	The maximum number of destroyed entities to reclaim
+		*	@param	MaxSeconds:		The maximum time to spend reclaiming, 0 for no time limit
+		*	@return	size_t:			The number of destroyed entities still waiting to be reclaimed
+		*/
+		size_t Maintain( size_t maxEntities = SIZE_MAX, float maxSeconds = 0.0f )
+		{
+			const auto start = std::chrono::steady_clock::now();
+
+			// Maintain is the world's sync point, changes recorded by other threads are applied first
+			FlushCommandBuffers();
+			DrainIngestionQueues();
+
+			for( size_t i = 0; i < maxEntities; ++i )
+			{
+				const EntityId entityId = m_enityManager->GetNextEntityMarkedForCleanUp();
+				if( entityId == 0 )	// Nothing left to reclaim
+				{
+					break;
+				}
+
+				// Components go first, the EntityId is free to be reused once the entity is cleaned up
+				m_componentManager->CleanUpComponents( entityId );
+				m_enityManager->CleanUpNextEntity();
+
+				if( maxSeconds > 0.0f && std::chrono::duration<float>( std::chrono::steady_clock::now() - start ).count() >= maxSeconds )
+				{
+					break;
+				}
+			}
+
+			m_componentManager->ReleaseUnusedMemory();
+
+			return m_enityManager->GetEntitiesMarkedForCleanUpCount();
+		}
+
+		// Moves the components of the passed entities into cold storage, optionally compressed, the entities leave their systems in one batch
+		// Prefabs are skipped, hibernating entities keep their EntityId but cannot be changed until they wake, returns the number of entities that started hibernating
+		size_t Hibernate( const std::vector<EntityId>& entities, bool bCompress = false )
+		{
+			return m_componentManager->Hibernate( entities, bCompress );
+		}
+
+		// Restores the components of the passed hibernating entities, the systems are updated once for the whole batch
+		size_t Wake( const std::vector<EntityId>& entities )
+		{
+			return m_componentManager->Wake( entities );
+		}
+
+		bool IsHibernating( EntityId entityId ) const
+		{
+			return m_componentManager->IsHibernating( entityId );
+		}
+
+		// The number of bytes held for hibernating entities, after compression
+		size_t GetHibernatingByteCount() const
+		{
+			return m_componentManager->GetHibernatingByteCount();
+		}
+
+		// The checksum of every component in the world, for lockstep peers to detect desyncs, only the chunks changed since the previous call are hashed
+		// In-place writes outside of System::ForEachChunk must be reported with NotifyComponentChanged or MarkComponentsChanged
+		uint32_t GetChecksum()
+		{
+			return m_componentManager->GetChecksum();
+		}
+
+		// The type key and checksum of each component type, in increasing order of type key, compare with a peer's to find the diverging type
+		void GetPoolChecksums( std::vector< std::pair<uint64_t, uint32_t> >& checksums )
+		{
+			m_componentManager->GetPoolChecksums( checksums );
+		}
+
+		// The checksum of each chunk of the component type with the passed type key, as of the last GetChecksum or GetPoolChecksums, returns nullptr if the type has no pool
+		const std::vector<uint32_t>* GetChunkChecksums( uint64_t typeKey ) const
+		{
+			return m_componentManager->GetChunkChecksums( typeKey );
+		}
+
+		// The layout of the component type with the passed signature index, see NEBULA_REFLECT, returns nullptr if the type has no pool
+		const ComponentDescriptor* FindDescriptor( size_t signatureIndex ) const
+		{
+			return m_componentManager->FindDescriptor( signatureIndex );
+		}
+
+		// Returns the first chunk whose checksum differs from the peer's, along with the owners of its components, ComponentManager::INVALID_CHUNK if none does
+		size_t FindDivergingChunk( uint64_t typeKey, const std::vector<uint32_t>& remoteChecksums, std::vector<EntityId>& entities ) const
+		{
+			return m_componentManager->FindDivergingChunk( typeKey, remoteChecksums, entities );
+		}
+
+		// Flags every component of type T as changed for the checksum, i.e. after writing to them through System::ForEach
+		template<typename T>
+		void MarkComponentsChanged()
+		{
+			m_componentManager->MarkComponentsChanged<T>();
+		}
+
+		// Disabled entities keep their components and systems, but are skipped by System::ForEach, System::ForEachChunk and Parser
+		// Returns false if the entity does not exist
+		bool SetEntityEnabled( EntityId entityId, bool bEnabled )
+		{
+			return m_enityManager->SetEntityEnabled( entityId, bEnabled );
+		}
+
+		bool IsEntityEnabled( EntityId entityId ) const
+		{
+			return m_enityManager->IsEntityEnabled( entityId );
+		}
+
+		// Replaces the allocator providing the memory of component storage, i.e. a MappedChunkAllocator for worlds larger than memory
+		// Must be called before the first component is added, the world takes ownership of the allocator if true is returned
+		bool SetChunkAllocator( ChunkAllocator* allocator )
+		{
+			return m_componentManager->SetChunkAllocator( allocator );
+		}
+
+		/*
+		*	Returns the command buffer of the calling thread, safe to call from any thread
+		*	Entities are created through the buffer without synchronization, the buffer's changes are applied by FlushCommandBuffers
+		*/
+		CommandBuffer& GetCommandBuffer()
+		{
+			CommandBuffer* commandBuffer = static_cast<CommandBuffer*>( m_commandBufferSlot.Get() );
+			if ( commandBuffer != nullptr )
+			{
+				return *commandBuffer;
+			}
+
+			commandBuffer = new CommandBuffer( m_enityManager );
+			{
+				std::lock_guard<std::mutex> lock( m_commandBuffersMutex );
+				m_commandBuffers.push_back( commandBuffer );
+			}
+			m_commandBufferSlot.Set( commandBuffer );
+
+			return *commandBuffer;
+		}
+
+		/*
+		*	Applies the changes recorded by every thread's command buffer, must be called from the main thread while no changes are being recorded
+		*	Called by Maintain, the entities created by all buffers exist before any buffer's changes are applied
+		*/
+		void FlushCommandBuffers()
+		{
+			std::lock_guard<std::mutex> lock( m_commandBuffersMutex );
+
+			for ( auto* commandBuffer : m_commandBuffers )
+			{
+				commandBuffer->CreateEntities( *m_enityManager );
+			}
+
+			for ( auto* commandBuffer : m_commandBuffers )
+			{
+				commandBuffer->ExecuteCommands( *m_enityManager, *m_componentManager );
+			}
+		}
+
+		/*
+		*	Creates a queue streaming records of the passed component types into this world from another thread, see IngestionQueue
+		*	The queue is owned by the world and drained by Maintain, its producer thread must stop pushing before the world is destroyed
+		*	@param	Capacity:		The number of records the queue holds, rounded up to a power of two
+		*	@param	MaxDrainCount:	The most records applied by a single drain, 0 for every waiting record
+		*/
+		template<typename ... Components>
+		IngestionQueue<Components ...>* CreateIngestionQueue( size_t capacity, size_t maxDrainCount = 0 )
+		{
+			IngestionQueue<Components ...>* ingestionQueue = new IngestionQueue<Components ...>( capacity, maxDrainCount );
+			m_ingestionQueues.push_back( ingestionQueue );
+			return ingestionQueue;
+		}
+
+		// Applies the records waiting in every ingestion queue, in one batch per queue, called by Maintain
+		void DrainIngestionQueues()
+		{
+			for ( auto* ingestionQueue : m_ingestionQueues )
+			{
+				ingestionQueue->Drain( *m_enityManager, *m_componentManager );
+			}
+		}
+
 		// Adds Component to entity with passed EntityId
 		template<typename T, typename ... Args>
 		T* AddComponentToEntity( EntityId entityId, Args&& ... args )
@@ -132,6 +411,97 @@ namespace Nebula
 		}
 
 
+		// Tells the field indices and the checksum of component type T that a component changed in place, see ComponentManager::NotifyComponentChanged
+		template<typename T>
+		void NotifyComponentChanged( EntityId entityId )
+		{
+			m_componentManager->NotifyComponentChanged<T>( entityId );
+		}
+
+		// Creates an index finding entities by the value of a field of component type T, i.e. CreateHashIndex( &PlayerComponent::m_team )
+		// The index is owned by the world, returns nullptr if the index could not be created
+		template<typename T, typename Key>
+		HashIndex<T, Key>* CreateHashIndex( Key T::* field )
+		{
+			return m_componentManager->CreateHashIndex<T, Key>( field );
+		}
+
+		// Creates an index keeping entities sorted by the value of a field of component type T, for range lookups
+		// The index is owned by the world, returns nullptr if the index could not be created
+		template<typename T, typename Key>
+		OrderedIndex<T, Key>* CreateOrderedIndex( Key T::* field )
+		{
+			return m_componentManager->CreateOrderedIndex<T, Key>( field );
+		}
+
+
+		// Makes the entity share the passed value with all entities holding an equal value of type T, each distinct value is stored once
+		// Returns false if the entity does not exist
+		template<typename T>
+		bool SetSharedComponent( EntityId entityId, const T& value )
+		{
+			return m_componentManager->SetSharedComponent<T>( entityId, value );
+		}
+
+		// Returns the value of type T shared by the entity, if it shares one
+		template<typename T>
+		const T* FindSharedComponent( EntityId entityId ) const
+		{
+			return m_componentManager->FindSharedComponent<T>( entityId );
+		}
+
+		// Stops the entity from sharing a value of type T
+		template<typename T>
+		void RemoveSharedComponent( EntityId entityId )
+		{
+			m_componentManager->RemoveSharedComponent<T>( entityId );
+		}
+
+
+		// Adds Tag to entity with passed EntityId, returns false if the entity does not exist or already has the tag
+		template<typename T>
+		bool AddTagToEntity( EntityId entityId )
+		{
+			return m_componentManager->AddTag<T>( entityId );
+		}
+
+		// Removes Tag from entity with passed EntityId, if Tag exists on entity
+		template<typename T>
+		void RemoveTagFromEntity( EntityId entityId )
+		{
+			m_componentManager->RemoveTag<T>( entityId );
+		}
+
+		// Returns true if the entity with passed EntityId has the Tag
+		template<typename T>
+		bool EntityHasTag( EntityId entityId )
+		{
+			return m_componentManager->HasTag<T>( entityId );
+		}
+
+
+		// Creates the world resource of type T, returns nullptr if the resource already exists
+		template<typename T, typename ... Args>
+		T* AddResource( Args&& ... args )
+		{
+			return m_resourceManager->AddResource<T, Args ...>( std::forward<Args>( args ) ... );
+		}
+
+		// Returns the world resource of type T, if it exists
+		template<typename T>
+		T* GetResource()
+		{
+			return m_resourceManager->GetResource<T>();
+		}
+
+		// Destroys the world resource of type T, if it exists
+		template<typename T>
+		void RemoveResource()
+		{
+			m_resourceManager->RemoveResource<T>();
+		}
+
+
 		// Registers Systems, inside of system manager
 		template<typename T>
 		T* RegisterSystem()
@@ -154,10 +524,75 @@ namespace Nebula
 		}
 
 
-		// Update World Systems
+		// Update World Systems, then publish the snapshots of the component types that have them and the events sent during the update
 		void Update( float deltaTime )
 		{
 			m_systemManager->Update( deltaTime );
+
+			m_componentManager->PublishSnapshots();
+
+			m_eventBus->SwapBuffers();
+		}
+
+		/*
+		*	Sends an event of type T, constructed from the passed arguments, readable by every system during the next update
+		*	Safe to call from any thread during an update, each thread appends to its own segment of the event type's queue
+		*/
+		template<typename T, typename ... Args>
+		void SendEvent( Args&& ... args )
+		{
+			EventQueue<T>* eventQueue = m_eventBus->GetQueue<T>();
+			if ( eventQueue != nullptr )
+			{
+				eventQueue->Send( std::forward<Args>( args ) ... );
+			}
+		}
+
+		/*
+		*	Returns the events of type T sent during the previous update, contiguous and in the order they were sent by each thread
+		*	The span is valid until the end of the current update, the span is empty if no event of type T was ever sent
+		*/
+		template<typename T>
+		EventSpan<T> ReadEvents() const
+		{
+			const EventQueue<T>* eventQueue = m_eventBus->FindQueue<T>();
+			return eventQueue != nullptr ? eventQueue->Read() : EventSpan<T>();
+		}
+
+		/*
+		*	Sets the function called right after an update of a system took longer than its budget, see ISystem::SetLatencyBudget
+		*	The function is called from the thread updating the world, pass nullptr to stop reporting
+		*/
+		void SetBudgetExceededCallback( SystemManager::BudgetExceededCallback callback )
+		{
+			m_systemManager->SetBudgetExceededCallback( std::move( callback ) );
+		}
+
+		/*
+		*	Copies the update latency histogram of every system, for export to monitoring, see LatencySnapshot
+		*	@param	bReset:		Starts every histogram over once copied
+		*/
+		void GetLatencySnapshots( std::vector<LatencySnapshot>& snapshots, bool bReset = false )
+		{
+			m_systemManager->GetLatencySnapshots( snapshots, bReset );
+		}
+
+		// Publishes the state of component type T at the end of every update, call before other threads start reading
+		template<typename T>
+		void EnableSnapshots()
+		{
+			m_componentManager->EnableSnapshots<T>();
+		}
+
+		/*
+		*	Returns a consistent view of the components of type T as of the end of the last update, safe to call from any thread
+		*	The reader is invalid if snapshots are not enabled for T or nothing has been published yet
+		*/
+		template<typename T>
+		typename ComponentSnapshot<T>::Reader ReadSnapshot() const
+		{
+			const ComponentSnapshot<T>* snapshot = m_componentManager->FindSnapshot<T>();
+			return snapshot != nullptr ? snapshot->Read() : typename ComponentSnapshot<T>::Reader();
 		}
 
 	private:
@@ -165,9 +600,7 @@ namespace Nebula
 		template<size_t INDEX, typename ComponentClass, typename ... Components>
 		void AddNewComponentToEntity( EntityId entityId )
 		{
-			// Complile-time check to see if class T can be converted to class B, 
-				// valid for derivation check of class T from class B
-			CanConvert_From<ComponentClass, Component>();
+			static_assert( IsComponent<ComponentClass>::value, "Components must derive from Component or be trivially copyable" );
 
 			if ( m_componentManager->AddComponent<ComponentClass>( entityId ) != nullptr )
 				// When we successfully add a component, carry on with the process
@@ -3,6 +3,8 @@
 #ifndef NEBULA_COMPILERHASH_H
 #define NEBULA_COMPILERHASH_H
 
+#include <cstddef>
+
 // Compile Time String Hashing, thank you to @tower120 & @redwizard792
 // https://stackoverflow.com/questions/2111667/compile-time-string-hashing
 
@@ -76,5 +78,18 @@ struct MM<size, size, dummy>
 #define COMPILE_TIME_CRC32_STR(x) (MM<sizeof(x)-1>::crc32(x))
 
 
+// Runtime counterpart of the above, continues 'prev_crc' over 'size' bytes
+// Chain calls to hash data in pieces, then finish the hash with crc ^ 0xFFFFFFFF
+inline unsigned int crc32_update( const void* data, size_t size, unsigned int prev_crc = 0xFFFFFFFF )
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>( data );
+	for( size_t i = 0; i < size; ++i )
+	{
+		prev_crc = ( prev_crc >> 8 ) ^ crc_table[( prev_crc ^ bytes[i] ) & 0xFF];
+	}
+	return prev_crc;
+}
+
+
 #endif // !NEBULA_COMPILERHASH_H
 
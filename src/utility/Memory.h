@@ -0,0 +1,51 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_MEMORY_H
+#define NEBULA_MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+namespace Nebula
+{
+	/*
+	*	Allocates a block of memory with its address aligned to the passed alignment
+	*	@param	Size:		The size in bytes of the block
+	*	@param	Alignment:	The alignment in bytes of the block, must be a power of two
+	*	@return	void*:		The aligned block, must be released with AlignedFree, returns nullptr if the allocation failed
+	*/
+	inline void* AlignedAlloc( size_t size, size_t alignment )
+	{
+		// Over-allocate to make room for the alignment offset and the address of the original block
+		void* block = std::malloc( size + alignment + sizeof( void* ) );
+
+		if( block == nullptr )
+		{
+			return nullptr;
+		}
+
+		const uintptr_t address = reinterpret_cast<uintptr_t>( block ) + sizeof( void* );
+		void* alignedBlock = reinterpret_cast<void*>( ( address + alignment - 1 ) & ~( static_cast<uintptr_t>( alignment ) - 1 ) );
+
+		// The original block is stored right before the aligned block
+		static_cast<void**>( alignedBlock )[-1] = block;
+
+		return alignedBlock;
+	}
+
+	/*
+	*	Releases a block of memory allocated with AlignedAlloc
+	*/
+	inline void AlignedFree( void* alignedBlock )
+	{
+		if( alignedBlock == nullptr )
+		{
+			return;
+		}
+
+		std::free( static_cast<void**>( alignedBlock )[-1] );
+	}
+}
+
+#endif // !NEBULA_MEMORY_H
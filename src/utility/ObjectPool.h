@@ -4,7 +4,7 @@
 #define NEBULA_OBJECTPOOL_H
 
 #include <vector>
-#include <map>
+#include <unordered_set>
 
 namespace Nebula
 {
@@ -61,6 +61,7 @@ namespace Nebula
 			{
 				return nullptr;
 			}
+			objectsTaken.insert( object );
 			return object;
 		}
 
@@ -76,6 +77,7 @@ namespace Nebula
 			}
 			object = objects[objects.size() - 1];
 			objects.pop_back();
+			objectsTaken.insert( object );
 			return object;
 		}
 
@@ -90,12 +92,10 @@ namespace Nebula
 				return;
 			}
 
-			for( const auto* obj : objects )
+			// Only objects handed out by this pool can be returned, which also rejects objects returned twice
+			if( objectsTaken.erase( object ) == 0 )
 			{
-				if( obj == object )
-				{
-					return;
-				}
+				return;
 			}
 			objects.push_back( object );
 		}
@@ -110,7 +110,7 @@ namespace Nebula
 		std::vector<T*> objects;
 
 		// Objects taken from the pool
-		// std::map<T*, int> objectsTaken;
+		std::unordered_set<T*> objectsTaken;
 	};
 }
 
@@ -3,6 +3,8 @@
 #ifndef NEBULA_TEMPLATEHELPER_H
 #define NEBULA_TEMPLATEHELPER_H
 
+#include <type_traits>
+
 namespace Nebula
 {
 	// Template Parameter Compile Constraint, Thanks Bjarne Stroustrup: https://www.stroustrup.com/bs_faq2.html#constraints
@@ -12,6 +14,17 @@ namespace Nebula
 		// Complile-time check to see if class T can be converted to class B, valid for derivation check of class T from class B
 		CanConvert_From() { void( *p )( T* ) = constraints; }
 	};
+
+	// Compile-time check to see if class T is one of the classes in Types
+	template<class T, class ... Types> struct IsOneOf
+	{
+		static constexpr bool value = false;
+	};
+
+	template<class T, class First, class ... Rest> struct IsOneOf<T, First, Rest ...>
+	{
+		static constexpr bool value = std::is_same<T, First>::value || IsOneOf<T, Rest ...>::value;
+	};
 }
 
 #endif // !NEBULA_TEMPLATEHELPER_H
@@ -0,0 +1,123 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_THREADLOCALSLOT_H
+#define NEBULA_THREADLOCALSLOT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace Nebula
+{
+	/*
+	*	Gives every thread its own pointer for the owner of the slot, i.e. the calling thread's command buffer of a world
+	*	Each thread keeps its pointers in an array indexed by slot, a pointer is found in constant time and without locks
+	*	Slots are recycled once their owner is destroyed, so the array of each thread only grows with the number of owners alive at once
+	*	A thread's pointer from a destroyed owner is never returned, every slot carries a generation unique to its owner
+	*/
+	class ThreadLocalSlot
+	{
+		ThreadLocalSlot( const ThreadLocalSlot& ) = delete;
+		ThreadLocalSlot( ThreadLocalSlot&& ) = delete;
+		ThreadLocalSlot& operator=( const ThreadLocalSlot& ) = delete;
+		ThreadLocalSlot& operator=( ThreadLocalSlot&& ) = delete;
+
+	public:
+		ThreadLocalSlot() :
+			m_index( AcquireIndex() ),
+			m_generation( NextGeneration() )
+		{}
+
+		~ThreadLocalSlot()
+		{
+			ReleaseIndex( m_index );
+		}
+
+		// Returns the calling thread's pointer, nullptr if the thread has not set one
+		inline void* Get() const
+		{
+			const std::vector<Entry>& entries = GetEntries();
+			return m_index < entries.size() && entries[m_index].m_generation == m_generation ? entries[m_index].m_value : nullptr;
+		}
+
+		// Sets the calling thread's pointer, the slot does not own it
+		void Set( void* value )
+		{
+			std::vector<Entry>& entries = GetEntries();
+			if( m_index >= entries.size() )
+			{
+				entries.resize( m_index + 1 );
+			}
+
+			entries[m_index].m_generation = m_generation;
+			entries[m_index].m_value = value;
+		}
+
+	private:
+		struct Entry
+		{
+			// 0 for an entry no slot has set yet
+			uint64_t	m_generation = 0;
+			void*		m_value = nullptr;
+		};
+
+		// The pointers of the calling thread, indexed by slot
+		static std::vector<Entry>& GetEntries()
+		{
+			thread_local std::vector<Entry> entries;
+			return entries;
+		}
+
+		static uint64_t NextGeneration()
+		{
+			static std::atomic<uint64_t> generationCounter( 0 );
+			return ++generationCounter;
+		}
+
+		// The indices released by destroyed slots, and the number of indices handed out so far
+		struct IndexPool
+		{
+			std::mutex			m_mutex;
+			std::vector<size_t>	m_freeIndices;
+			size_t				m_indexCount = 0;
+		};
+
+		static IndexPool& GetIndexPool()
+		{
+			static IndexPool indexPool;
+			return indexPool;
+		}
+
+		static size_t AcquireIndex()
+		{
+			IndexPool& indexPool = GetIndexPool();
+			std::lock_guard<std::mutex> lock( indexPool.m_mutex );
+
+			if( indexPool.m_freeIndices.empty() )
+			{
+				return indexPool.m_indexCount++;
+			}
+
+			const size_t index = indexPool.m_freeIndices.back();
+			indexPool.m_freeIndices.pop_back();
+			return index;
+		}
+
+		static void ReleaseIndex( size_t index )
+		{
+			IndexPool& indexPool = GetIndexPool();
+			std::lock_guard<std::mutex> lock( indexPool.m_mutex );
+			indexPool.m_freeIndices.push_back( index );
+		}
+
+		// The place of this slot inside of every thread's array
+		const size_t	m_index;
+
+		// Unique across all slots of the process
+		const uint64_t	m_generation;
+	};
+}
+
+#endif // !NEBULA_THREADLOCALSLOT_H
@@ -0,0 +1,35 @@
+// MIT License, Copyright (c) 2019 Malik Allen
+
+#ifndef NEBULA_TYPEINDEX_H
+#define NEBULA_TYPEINDEX_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace Nebula
+{
+	/*
+	*	Hands out small, dense, sequential indices for types, starting at 0 for each Family
+	*	Indices are assigned the first time a type is queried and remain stable for the lifetime of the program
+	*	Unlike the sparse CRC32 'ID' of a type, these indices can be used to address arrays and bit-masks directly
+	*/
+	template<typename Family>
+	class TypeIndex
+	{
+		static size_t Next()
+		{
+			static std::atomic<size_t> counter( 0 );
+			return counter++;
+		}
+
+	public:
+		template<typename T>
+		static size_t Get()
+		{
+			static const size_t index = Next();
+			return index;
+		}
+	};
+}
+
+#endif // !NEBULA_TYPEINDEX_H